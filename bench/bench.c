@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../jsmn.h"
+#include "../jsmn_soa.h"
+#include "../jsmn_canon.h"
+#include "../jsmn_diff.h"
+#include "bench.h"
+
+/*
+ * Parser throughput benchmark. The same source is built twice by the
+ * Makefile: linked with the jsmn library and with JSMN_STATIC, so the
+ * numbers show what inlining the parser into the caller buys.
+ */
+
+#ifdef JSMN_STATIC
+#define BENCH_MODE "static"
+#else
+#define BENCH_MODE "library"
+#endif
+
+/* Parses js BENCH_ROUNDS times and prints throughput */
+static int bench_run(const char *label, const char *js, size_t len,
+		const jsmn_keyset *keys, jsmn_intern *intern) {
+	jsmn_parser p;
+	jsmntok_t *tok;
+	int ntok;
+	int i;
+	clock_t start;
+	double secs;
+
+	jsmn_init(&p);
+	p.keys = keys;
+	ntok = jsmn_parse(&p, js, len, NULL, 0);
+	tok = malloc(sizeof(*tok) * ntok);
+	if (tok == NULL) {
+		return 3;
+	}
+	if (intern != NULL) {
+		intern->ids = malloc(sizeof(int) * ntok);
+		if (intern->ids == NULL) {
+			return 3;
+		}
+	}
+
+	start = clock();
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		jsmn_init(&p);
+		p.keys = keys;
+		p.intern = intern;
+		if (jsmn_parse(&p, js, len, tok, ntok) != ntok) {
+			fprintf(stderr, "parse failed\n");
+			return 1;
+		}
+	}
+	secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+	printf("%-8s %-6s %8d tokens %10lu bytes %8.1f MB/s\n", BENCH_MODE, label,
+			ntok, (unsigned long) len, len * (double) BENCH_ROUNDS / secs / 1e6);
+	free(tok);
+	if (intern != NULL) {
+		free(intern->ids);
+	}
+	return 0;
+}
+
+/*
+ * Parses js into a structure of arrays, then counts the strings of the
+ * document, once over the type column and once over jsmntok_t.
+ */
+static int bench_soa(const char *js, size_t len) {
+	jsmn_parser p;
+	jsmn_soa soa;
+	jsmntok_t *tok;
+	char *buf;
+	unsigned int ntok, n, k;
+	int i;
+	clock_t start;
+	double secs, aos, col;
+
+	jsmn_init(&p);
+	ntok = (unsigned int) jsmn_parse(&p, js, len, NULL, 0);
+	buf = malloc(ntok * (1 + 4 * sizeof(jsmnint_t)));
+	tok = malloc(ntok * sizeof(*tok));
+	if (buf == NULL || tok == NULL) {
+		return 3;
+	}
+	soa.start = (jsmnint_t *) buf;
+	soa.end = soa.start + ntok;
+	soa.size = soa.end + ntok;
+	soa.parent = soa.size + ntok;
+	soa.type = (unsigned char *) (soa.parent + ntok);
+	jsmn_init(&p);
+	jsmn_parse(&p, js, len, tok, ntok);
+
+	start = clock();
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		jsmn_init(&p);
+		if (jsmn_parse_soa(&p, js, len, &soa, ntok) != (int) ntok) {
+			fprintf(stderr, "parse failed\n");
+			return 1;
+		}
+	}
+	secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+	printf("%-8s %-6s %8u tokens %10lu bytes %8.1f MB/s\n", BENCH_MODE, "soa",
+			ntok, (unsigned long) len, len * (double) BENCH_ROUNDS / secs / 1e6);
+
+	n = 0;
+	start = clock();
+	for (i = 0; i < BENCH_ROUNDS * 10; i++) {
+		for (k = 0; k < ntok; k++) {
+			n += tok[k].type == JSMN_STRING;
+		}
+		n -= i;
+	}
+	aos = (double) (clock() - start) / CLOCKS_PER_SEC;
+	start = clock();
+	for (i = 0; i < BENCH_ROUNDS * 10; i++) {
+		n += jsmn_soa_count(&soa, 0, ntok, JSMN_STRING);
+		n -= i;
+	}
+	col = (double) (clock() - start) / CLOCKS_PER_SEC;
+	printf("%-8s %-6s %8.2f ns/token jsmntok_t %8.2f ns/token column (%u)\n",
+			BENCH_MODE, "count", aos * 1e9 / ntok / (BENCH_ROUNDS * 10),
+			col * 1e9 / ntok / (BENCH_ROUNDS * 10), n);
+	free(buf);
+	free(tok);
+	return 0;
+}
+
+/*
+ * Minifies and canonicalizes the parsed document into one buffer.
+ */
+static int bench_canon(const char *js, size_t len) {
+	jsmn_parser p;
+	jsmn_writer w;
+	jsmntok_t *tok;
+	char *out;
+	int *scratch;
+	int ntok, i, k;
+	clock_t start;
+	double secs;
+
+	jsmn_init(&p);
+	ntok = jsmn_parse(&p, js, len, NULL, 0);
+	tok = malloc(ntok * sizeof(*tok));
+	scratch = malloc(ntok * sizeof(*scratch));
+	out = malloc(2 * len);
+	if (tok == NULL || scratch == NULL || out == NULL) {
+		return 3;
+	}
+	jsmn_init(&p);
+	jsmn_parse(&p, js, len, tok, ntok);
+
+	for (k = 0; k < 2; k++) {
+		start = clock();
+		for (i = 0; i < BENCH_ROUNDS; i++) {
+			jsmn_writer_init(&w, out, 2 * len);
+			if ((k == 0 ? jsmn_minify(&w, js, tok, ntok) :
+						jsmn_canonicalize(&w, js, tok, ntok, scratch)) < 0 ||
+					w.len > w.size) {
+				fprintf(stderr, "canonicalize failed\n");
+				return 1;
+			}
+		}
+		secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+		printf("%-8s %-6s %8d tokens %10lu bytes %8.1f MB/s\n", BENCH_MODE,
+				k == 0 ? "minify" : "canon", ntok, (unsigned long) w.len,
+				len * (double) BENCH_ROUNDS / secs / 1e6);
+	}
+	free(tok);
+	free(scratch);
+	free(out);
+	return 0;
+}
+
+/*
+ * Compares the parsed document with a copy where one value of the last
+ * record changed: jsmn_diff() against comparing every token by hand.
+ */
+static int bench_diff(const char *js, size_t len) {
+	jsmn_parser p;
+	jsmn_doc a, b;
+	jsmn_change change;
+	jsmntok_t *tok;
+	char *copy;
+	int *scratch;
+	int ntok, i, j, k, r = 0;
+	clock_t start;
+	double secs;
+
+	jsmn_init(&p);
+	ntok = jsmn_parse(&p, js, len, NULL, 0);
+	tok = malloc(2 * ntok * sizeof(*tok));
+	scratch = malloc(2 * ntok * sizeof(*scratch));
+	copy = malloc(len + 1);
+	if (tok == NULL || scratch == NULL || copy == NULL) {
+		return 3;
+	}
+	memcpy(copy, js, len + 1);
+	memcpy(strstr(copy + len - 256, "true"), "null", 4);
+	a.js = js;
+	a.tokens = tok;
+	b.js = copy;
+	b.tokens = tok + ntok;
+	jsmn_init(&p);
+	a.num_tokens = jsmn_parse(&p, js, len, tok, ntok);
+	jsmn_init(&p);
+	b.num_tokens = jsmn_parse(&p, copy, len, tok + ntok, ntok);
+
+	for (k = 0; k < 3; k++) {
+		start = clock();
+		for (i = 0; i < BENCH_ROUNDS; i++) {
+			if (k == 0) {
+				for (j = 0, r = 0; j < ntok; j++) {
+					const jsmntok_t *x = &a.tokens[j];
+					const jsmntok_t *y = &b.tokens[j];
+					r += x->type != y->type || x->size != y->size ||
+						(x->type != JSMN_OBJECT && x->type != JSMN_ARRAY &&
+						 (x->end - x->start != y->end - y->start ||
+						  memcmp(js + x->start, copy + y->start,
+							  x->end - x->start) != 0));
+				}
+			} else {
+				r = jsmn_diff(&a, &b, k == 2 ? JSMN_DIFF_UNORDERED : 0,
+						scratch, &change, 1);
+			}
+			if (r != 1) {
+				fprintf(stderr, "diff failed\n");
+				return 1;
+			}
+		}
+		secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+		printf("%-8s %-9s %8d tokens %8.1f MB/s\n", BENCH_MODE,
+				k == 0 ? "tokens" : k == 1 ? "diff" : "unordered", ntok,
+				len * (double) BENCH_ROUNDS / secs / 1e6);
+	}
+	free(tok);
+	free(scratch);
+	free(copy);
+	return 0;
+}
+
+int main(void) {
+	/* Typical selective consumer: 2 of the 9 record members */
+	static const char *names[] = { "id", "score" };
+	jsmn_keyset keys;
+	jsmn_intern intern;
+	jsmn_intern_slot slots[64];
+	char names_buf[512];
+	size_t len;
+	char *js;
+	int r;
+
+	js = bench_document(&len);
+	if (js == NULL) {
+		return 3;
+	}
+	jsmn_keyset_init(&keys, names, 2);
+	jsmn_intern_init(&intern, slots, 64, names_buf, sizeof(names_buf));
+
+	r = bench_run("all", js, len, NULL, NULL);
+	if (r == 0) {
+		r = bench_run("keys", js, len, &keys, NULL);
+	}
+	if (r == 0) {
+		r = bench_run("intern", js, len, NULL, &intern);
+	}
+	if (r == 0) {
+		r = bench_soa(js, len);
+	}
+	if (r == 0) {
+		r = bench_canon(js, len);
+	}
+	if (r == 0) {
+		r = bench_diff(js, len);
+	}
+	free(js);
+	return r == 0 ? EXIT_SUCCESS : r;
+}
@@ -0,0 +1,43 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Document of the parser throughput benchmarks, shared by bench.c and
+ * bench_cpp.cpp so their numbers can be compared.
+ */
+
+#define BENCH_RECORDS 2000
+#define BENCH_ROUNDS 200
+
+static const char *BENCH_RECORD =
+	"{\"id\": %d, \"name\": \"user %d\", \"active\": true, \"score\": 12.5,\n"
+	"  \"tags\": [\"alpha\", \"beta\", \"gamma\"], \"owner\": null,\n"
+	"  \"geo\": {\"lat\": -33.8688, \"lon\": 151.2093, \"note\": \"\\u00e9t\\u00e9\"}}";
+
+/* Builds an array of BENCH_RECORDS mixed records */
+static char *bench_document(size_t *len) {
+	size_t cap = BENCH_RECORDS * 256 + 16;
+	size_t n = 0;
+	char *js = (char *) malloc(cap);
+	int i;
+
+	if (js == NULL) {
+		return NULL;
+	}
+	js[n++] = '[';
+	for (i = 0; i < BENCH_RECORDS; i++) {
+		if (i > 0) {
+			js[n++] = ',';
+		}
+		n += sprintf(js + n, BENCH_RECORD, i, i);
+	}
+	js[n++] = ']';
+	js[n] = '\0';
+	*len = n;
+	return js;
+}
+
+#endif /* __BENCH_H__ */
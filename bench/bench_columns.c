@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Loads NDJSON records into columns: jsmn_parse() per line, a key scan over
+ * the tokens and strtoll()/strtod(), against jsmn_columns_load().
+ */
+
+#define JSMN_STATIC
+#include "../jsmn.h"
+#include "../jsmn_bind.c"
+#include "../jsmn_columns.c"
+
+#define BENCH_RECORDS 100000
+#define BENCH_ROUNDS 10
+
+static const char *BENCH_RECORD =
+	"{\"id\": %d, \"user\": {\"name\": \"user %d\", \"score\": %d.%02d, "
+	"\"active\": true}, \"tags\": [\"alpha\", \"beta\"], \"owner\": null}\n";
+
+static long long *bench_ids;
+static double *bench_scores;
+static char *bench_names;
+
+static int bench_key(const char *js, const jsmntok_t *t, const char *key) {
+	size_t len = strlen(key);
+	return t->type == JSMN_STRING && (size_t) (t->end - t->start) == len &&
+		memcmp(js + t->start, key, len) == 0;
+}
+
+static int bench_skip(const jsmntok_t *t, int n, int i) {
+	int end = t[i].end;
+
+	for (i++; i < n && t[i].start < end; i++);
+	return i;
+}
+
+/* One jsmn_parse() per line, as done before the loader */
+static int bench_tokens(const char *js, size_t len) {
+	jsmntok_t t[64];
+	jsmn_parser p;
+	size_t line = 0, names = 0;
+	int rows = 0;
+
+	while (line < len) {
+		const char *nl = memchr(js + line, '\n', len - line);
+		size_t end = nl ? (size_t) (nl - js) : len;
+		int n, i;
+
+		jsmn_init(&p);
+		n = jsmn_parse(&p, js + line, end - line, t, 64);
+		if (n <= 0) {
+			return -1;
+		}
+		for (i = 1; i < n; i = bench_skip(t, n, i + 1)) {
+			const char *s = js + line;
+			if (bench_key(s, &t[i], "id")) {
+				bench_ids[rows] = strtoll(s + t[i + 1].start, NULL, 10);
+			} else if (bench_key(s, &t[i], "user")) {
+				int j, k = bench_skip(t, n, i + 1);
+				for (j = i + 2; j < k; j = bench_skip(t, n, j + 1)) {
+					if (bench_key(s, &t[j], "score")) {
+						bench_scores[rows] = strtod(s + t[j + 1].start, NULL);
+					} else if (bench_key(s, &t[j], "name")) {
+						size_t m = t[j + 1].end - t[j + 1].start;
+						memcpy(bench_names + names, s + t[j + 1].start, m);
+						names += m;
+					}
+				}
+			}
+		}
+		rows++;
+		line = end + 1;
+	}
+	return rows;
+}
+
+static int bench_columns(const char *js, size_t len) {
+	jsmn_column cols[3];
+	jsmn_columns loader;
+	int r;
+
+	cols[0].path = "id";
+	cols[0].type = JSMN_COLUMN_INT64;
+	cols[1].path = "user.score";
+	cols[1].type = JSMN_COLUMN_DOUBLE;
+	cols[2].path = "user.name";
+	cols[2].type = JSMN_COLUMN_STRING;
+	if (jsmn_columns_init(&loader, cols, 3) < 0) {
+		return -1;
+	}
+	r = jsmn_columns_load(&loader, js, len);
+	jsmn_columns_free(&loader);
+	return r;
+}
+
+static double bench_time(const char *js, size_t len,
+		int (*load)(const char *js, size_t len)) {
+	clock_t start = clock();
+	int i;
+
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		if (load(js, len) != BENCH_RECORDS) {
+			return -1;
+		}
+	}
+	return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(void) {
+	char *js = malloc(BENCH_RECORDS * 160);
+	size_t len = 0;
+	double secs;
+	int i;
+
+	bench_ids = malloc(BENCH_RECORDS * sizeof(long long));
+	bench_scores = malloc(BENCH_RECORDS * sizeof(double));
+	bench_names = malloc(BENCH_RECORDS * 16);
+	if (js == NULL || bench_ids == NULL || bench_scores == NULL ||
+			bench_names == NULL) {
+		return 3;
+	}
+	for (i = 0; i < BENCH_RECORDS; i++) {
+		len += sprintf(js + len, BENCH_RECORD, i, i, i % 100, i % 97);
+	}
+
+	secs = bench_time(js, len, bench_tokens);
+	if (secs < 0) {
+		fprintf(stderr, "tokens: load failed\n");
+		return 1;
+	}
+	printf("tokens   %8.1f MB/s %10.0f rows/s\n",
+			len * BENCH_ROUNDS / secs / 1e6, BENCH_RECORDS * BENCH_ROUNDS / secs);
+	secs = bench_time(js, len, bench_columns);
+	if (secs < 0) {
+		fprintf(stderr, "columns: load failed\n");
+		return 1;
+	}
+	printf("columns  %8.1f MB/s %10.0f rows/s\n",
+			len * BENCH_ROUNDS / secs / 1e6, BENCH_RECORDS * BENCH_ROUNDS / secs);
+	free(js);
+	free(bench_ids);
+	free(bench_scores);
+	free(bench_names);
+	return 0;
+}
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <string_view>
+#include <vector>
+
+#include "../jsmn.hpp"
+#include "bench.h"
+
+/*
+ * Throughput of the C++ parser on the same document as bench.c, compare
+ * with the numbers printed by bench_lib and bench_static. Tokens of c_policy
+ * are those of bench_lib, the linked policy shows what parent links cost.
+ */
+
+template <typename Policy>
+static int bench_run(const char *label, std::string_view js) {
+	jsmn::parser<Policy> p;
+	std::vector<typename Policy::token_type> tok;
+	int ntok;
+	int i;
+	clock_t start;
+	double secs;
+
+	ntok = p.count(js);
+	tok.resize(ntok);
+
+	start = clock();
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		p.reset();
+		if (p.parse(js, tok.data(), ntok) != ntok) {
+			fprintf(stderr, "parse failed\n");
+			return -1;
+		}
+	}
+	secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+	printf("%-8s %8d tokens %10lu bytes %8.1f MB/s\n", label, ntok,
+			(unsigned long) js.size(), js.size() * (double) BENCH_ROUNDS / secs / 1e6);
+	return 0;
+}
+
+int main(void) {
+	char *doc;
+	size_t len;
+	int r;
+
+	doc = bench_document(&len);
+	if (doc == NULL) {
+		return 1;
+	}
+	r = bench_run<jsmn::c_policy>("c++", std::string_view(doc, len));
+	if (r == 0) {
+		r = bench_run<jsmn::default_policy>("c++ link",
+				std::string_view(doc, len));
+	}
+	free(doc);
+	return r < 0 ? 1 : EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Server-like load: several threads each handle many requests of varying
+ * size. Compares a malloc/parse/free cycle per request (as in
+ * example/jsondump.c) with pooled parser contexts, counting allocator calls.
+ */
+
+static _Thread_local unsigned long bench_allocs;
+
+static void *bench_realloc(void *p, size_t size) {
+	bench_allocs++;
+	return realloc(p, size);
+}
+
+static void bench_free(void *p) {
+	bench_allocs++;
+	free(p);
+}
+
+#define JSMN_STATIC
+#define JSMN_POOL_REALLOC bench_realloc
+#define JSMN_POOL_FREE bench_free
+#include "../jsmn.h"
+#include "../jsmn_pool.c"
+
+#define BENCH_THREADS 4
+#define BENCH_REQUESTS 20000
+#define BENCH_SIZES 16
+
+static const char *BENCH_RECORD =
+	"{\"id\": %d, \"name\": \"user %d\", \"active\": true, \"score\": 12.5,\n"
+	"  \"tags\": [\"alpha\", \"beta\", \"gamma\"], \"owner\": null}";
+
+/* Request bodies: arrays of 1, 3, 5... records */
+static char *bench_docs[BENCH_SIZES];
+static size_t bench_lens[BENCH_SIZES];
+
+static char *bench_document(int records, size_t *len) {
+	char *js = malloc(records * 160 + 16);
+	size_t n = 0;
+	int i;
+
+	if (js == NULL) {
+		return NULL;
+	}
+	js[n++] = '[';
+	for (i = 0; i < records; i++) {
+		if (i > 0) {
+			js[n++] = ',';
+		}
+		n += sprintf(js + n, BENCH_RECORD, i, i);
+	}
+	js[n++] = ']';
+	js[n] = '\0';
+	*len = n;
+	return js;
+}
+
+/* Request handling as in example/jsondump.c */
+static int bench_request_malloc(const char *js, size_t len) {
+	jsmn_parser p;
+	jsmntok_t *tok;
+	unsigned int tokcount = JSMN_POOL_MIN;
+	int r;
+
+	tok = bench_realloc(NULL, sizeof(*tok) * tokcount);
+	if (tok == NULL) {
+		return -1;
+	}
+	jsmn_init(&p);
+	while ((r = jsmn_parse(&p, js, len, tok, tokcount)) == JSMN_ERROR_NOMEM) {
+		tokcount *= 2;
+		tok = bench_realloc(tok, sizeof(*tok) * tokcount);
+		if (tok == NULL) {
+			return -1;
+		}
+	}
+	bench_free(tok);
+	return r;
+}
+
+static int bench_request_pool(const char *js, size_t len) {
+	jsmn_ctx *ctx = jsmn_ctx_get();
+	int r;
+
+	if (ctx == NULL) {
+		return -1;
+	}
+	r = jsmn_ctx_parse(ctx, js, len);
+	jsmn_ctx_put(ctx);
+	return r;
+}
+
+typedef struct {
+	int (*request)(const char *js, size_t len);
+	unsigned int seed;
+	unsigned long allocs;
+	int failed;
+} bench_thread;
+
+static void *bench_worker(void *arg) {
+	bench_thread *t = arg;
+	int i, k;
+
+	bench_allocs = 0;
+	for (i = 0; i < BENCH_REQUESTS; i++) {
+		/* Mostly small requests, now and then a big one */
+		t->seed = t->seed * 1103515245 + 12345;
+		k = (t->seed >> 16) % 64;
+		k = k == 0 ? BENCH_SIZES - 1 : k % (BENCH_SIZES - 1);
+		if (t->request(bench_docs[k], bench_lens[k]) <= 0) {
+			t->failed = 1;
+		}
+	}
+	jsmn_pool_trim();
+	t->allocs = bench_allocs;
+	return NULL;
+}
+
+static int bench_run(const char *label,
+		int (*request)(const char *js, size_t len)) {
+	pthread_t threads[BENCH_THREADS];
+	bench_thread t[BENCH_THREADS];
+	struct timespec start, end;
+	unsigned long allocs = 0;
+	double secs;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < BENCH_THREADS; i++) {
+		t[i].request = request;
+		t[i].seed = i + 1;
+		t[i].allocs = 0;
+		t[i].failed = 0;
+		if (pthread_create(&threads[i], NULL, bench_worker, &t[i]) != 0) {
+			return 3;
+		}
+	}
+	for (i = 0; i < BENCH_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+		if (t[i].failed) {
+			fprintf(stderr, "parse failed\n");
+			return 1;
+		}
+		allocs += t[i].allocs;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	printf("%-8s %d threads %8.3f allocator calls/request %10.0f requests/s\n",
+			label, BENCH_THREADS,
+			(double) allocs / (BENCH_THREADS * BENCH_REQUESTS),
+			BENCH_THREADS * BENCH_REQUESTS / secs);
+	return 0;
+}
+
+int main(void) {
+	int i, r;
+
+	for (i = 0; i < BENCH_SIZES; i++) {
+		bench_docs[i] = bench_document(i == BENCH_SIZES - 1 ? 200 : 2 * i + 1,
+				&bench_lens[i]);
+		if (bench_docs[i] == NULL) {
+			return 3;
+		}
+	}
+	r = bench_run("malloc", bench_request_malloc);
+	if (r == 0) {
+		r = bench_run("pool", bench_request_pool);
+	}
+	for (i = 0; i < BENCH_SIZES; i++) {
+		free(bench_docs[i]);
+	}
+	return r == 0 ? EXIT_SUCCESS : r;
+}
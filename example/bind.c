@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include "../jsmn.h"
+#include "../jsmn_bind.h"
+
+/*
+ * Same document as in simple.c, decoded into a struct by a schema instead of
+ * comparing keys one by one.
+ */
+
+static const char *JSON_STRING =
+	"{\"user\": \"johndoe\", \"admin\": false, \"uid\": 1000,\n  "
+	"\"groups\": [\"users\", \"wheel\", \"audio\", \"video\"]}";
+
+struct user {
+	char name[32];
+	int admin;
+	int uid;
+};
+
+static const jsmn_field user_fields[] = {
+	JSMN_FIELD(struct user, name, "user", JSMN_BIND_STRING),
+	JSMN_FIELD(struct user, admin, "admin", JSMN_BIND_BOOL),
+	JSMN_FIELD(struct user, uid, "uid", JSMN_BIND_INT),
+};
+
+int main() {
+	int r;
+	jsmn_parser p;
+	jsmntok_t t[128]; /* We expect no more than 128 tokens */
+	jsmn_schema schema;
+	struct user u;
+
+	jsmn_schema_init(&schema, user_fields,
+			sizeof(user_fields)/sizeof(user_fields[0]));
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, JSON_STRING, strlen(JSON_STRING), t, sizeof(t)/sizeof(t[0]));
+	if (r < 0) {
+		printf("Failed to parse JSON: %d\n", r);
+		return 1;
+	}
+
+	/* Members without a field ("groups") are skipped */
+	memset(&u, 0, sizeof(u));
+	if (jsmn_bind(JSON_STRING, t, r, &schema, &u) < 0) {
+		printf("Unexpected value types\n");
+		return 1;
+	}
+	printf("- User: %s\n", u.name);
+	printf("- Admin: %s\n", u.admin ? "true" : "false");
+	printf("- UID: %d\n", u.uid);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,485 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef JSMN_INGEST_URING
+#include <liburing.h>
+#endif
+#include "../jsmn.h"
+
+/*
+ * Reads a log of newline delimited JSON records and parses every record,
+ * once in each of two ways:
+ * 	o serial - read a chunk, parse its records, read the next chunk, the
+ * 	  loop of jsondump.c
+ * 	o pipeline - a reader fills a ring of buffers ahead of the parse while
+ * 	  worker threads parse the filled ones. The reader uses io_uring if
+ * 	  built with JSMN_INGEST_URING (make ingest INGEST_URING=1) and the
+ * 	  kernel allows it, else pread() running next to the workers.
+ * It prints the throughput of both and checks they saw the same records.
+ *
+ * 	ingest [-t threads] [-n buffers] [-b KiB per buffer] [-d] file
+ *
+ * -d opens the file with O_DIRECT, so reads come from the disk and not from
+ * the page cache. A record may be at most one buffer long.
+ */
+
+typedef struct {
+	unsigned long records;
+	unsigned long tokens;
+	unsigned long errors;
+} ingest_count;
+
+/*
+ * Buffer of the ring: chunk bytes of room for the unfinished record of the
+ * previous buffer, then chunk bytes read from the file. Records to parse
+ * are buf[begin] up to buf[end].
+ */
+typedef struct {
+	char *buf;
+	size_t len; /* bytes read */
+	unsigned long seq; /* chunk of the file */
+	size_t begin;
+	size_t end;
+	int busy; /* being read, queued or being parsed */
+	int read; /* read completed, not framed yet */
+} ingest_slot;
+
+typedef struct {
+	ingest_slot *slots;
+	unsigned int num_slots;
+	size_t chunk;
+	int fd;
+	off_t size;
+	unsigned long num_chunks;
+	/*
+	 * Copy of the unfinished last record of the last framed slot: that
+	 * slot can be parsed, freed and read into again before the next one
+	 * is framed
+	 */
+	char *carry;
+	size_t carry_len;
+	/* Slots by sequence number: next to parse, one past the last framed */
+	unsigned long next;
+	unsigned long framed;
+	int eof;
+	ingest_count count;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+	pthread_cond_t free;
+} ingest_ring;
+
+static double ingest_now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/*
+ * Parses each line of js as a record, growing *tok as needed.
+ */
+static void ingest_parse(const char *js, size_t len, jsmntok_t **tok,
+		unsigned int *num_tokens, ingest_count *c) {
+	size_t i = 0;
+
+	while (i < len) {
+		const char *nl = memchr(js + i, '\n', len - i);
+		size_t end = nl ? (size_t) (nl - js) : len;
+		jsmn_parser p;
+		int r;
+
+		jsmn_init(&p);
+again:
+		r = jsmn_parse(&p, js + i, end - i, *tok, *num_tokens);
+		if (r == JSMN_ERROR_NOMEM) {
+			jsmntok_t *t = realloc(*tok, sizeof(**tok) * *num_tokens * 2);
+			if (t != NULL) {
+				*tok = t;
+				*num_tokens *= 2;
+				goto again;
+			}
+		}
+		if (r > 0) {
+			c->records++;
+			c->tokens += r;
+		} else if (r < 0) {
+			c->errors++;
+		}
+		i = end + 1;
+	}
+}
+
+/*
+ * Reads chunk seq into s, short only at the end of the file.
+ */
+static int ingest_read(ingest_ring *r, ingest_slot *s, unsigned long seq) {
+	off_t off = (off_t) seq * r->chunk;
+	size_t want = r->size - off < (off_t) r->chunk ?
+		(size_t) (r->size - off) : r->chunk;
+	ssize_t n;
+
+	/* O_DIRECT wants whole blocks, so always ask for a chunk */
+	do {
+		n = pread(r->fd, s->buf + r->chunk, r->chunk, off);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0 || (size_t) n != want) {
+		fprintf(stderr, "read at %ld: %s\n", (long) off,
+				n < 0 ? strerror(errno) : "short read");
+		return -1;
+	}
+	s->len = n;
+	return 0;
+}
+
+/*
+ * Puts the carried record in front of the bytes read into s, and ends the
+ * records of s at its last newline. The rest is copied out to be carried to
+ * the next slot.
+ */
+static int ingest_frame(ingest_ring *r, ingest_slot *s, int last) {
+	size_t begin = r->chunk - r->carry_len;
+	size_t end = r->chunk + s->len;
+	size_t nl = end;
+
+	if (r->carry_len > 0) {
+		memcpy(s->buf + begin, r->carry, r->carry_len);
+	}
+	if (!last) {
+		while (nl > begin && s->buf[nl - 1] != '\n') {
+			nl--;
+		}
+		if (end - nl > r->chunk) {
+			fprintf(stderr, "record longer than a buffer\n");
+			return -1;
+		}
+	}
+	s->begin = begin;
+	s->end = nl;
+	r->carry_len = end - nl;
+	if (r->carry_len > 0) {
+		memcpy(r->carry, s->buf + nl, r->carry_len);
+	}
+	return 0;
+}
+
+/* Hands the framed slot seq to the workers */
+static void ingest_push(ingest_ring *r, unsigned long seq) {
+	pthread_mutex_lock(&r->lock);
+	r->framed = seq + 1;
+	pthread_cond_signal(&r->ready);
+	pthread_mutex_unlock(&r->lock);
+}
+
+static void *ingest_worker(void *arg) {
+	ingest_ring *r = arg;
+	unsigned int num_tokens = 64;
+	jsmntok_t *tok = malloc(sizeof(*tok) * num_tokens);
+	ingest_count c = { 0, 0, 0 };
+
+	pthread_mutex_lock(&r->lock);
+	for (;;) {
+		ingest_slot *s;
+
+		while (r->next == r->framed && !r->eof) {
+			pthread_cond_wait(&r->ready, &r->lock);
+		}
+		if (r->next == r->framed) {
+			break;
+		}
+		s = &r->slots[r->next++ % r->num_slots];
+		pthread_mutex_unlock(&r->lock);
+
+		if (tok != NULL) {
+			ingest_parse(s->buf + s->begin, s->end - s->begin, &tok,
+					&num_tokens, &c);
+		}
+
+		pthread_mutex_lock(&r->lock);
+		s->busy = 0;
+		pthread_cond_signal(&r->free);
+	}
+	r->count.records += c.records;
+	r->count.tokens += c.tokens;
+	r->count.errors += c.errors;
+	pthread_mutex_unlock(&r->lock);
+	free(tok);
+	return NULL;
+}
+
+/* Reads the chunks in order, each into the next slot the workers freed */
+static int ingest_reader_pread(ingest_ring *r) {
+	unsigned long seq;
+
+	for (seq = 0; seq < r->num_chunks; seq++) {
+		ingest_slot *s = &r->slots[seq % r->num_slots];
+
+		pthread_mutex_lock(&r->lock);
+		while (s->busy) {
+			pthread_cond_wait(&r->free, &r->lock);
+		}
+		s->busy = 1;
+		pthread_mutex_unlock(&r->lock);
+
+		if (ingest_read(r, s, seq) < 0 ||
+				ingest_frame(r, s, seq + 1 == r->num_chunks) < 0) {
+			return -1;
+		}
+		ingest_push(r, seq);
+	}
+	return 0;
+}
+
+#ifdef JSMN_INGEST_URING
+/*
+ * Keeps a read in flight for every free slot. Reads complete in any order,
+ * slots are framed and handed to the workers in file order. Returns 1 if
+ * io_uring is not available.
+ */
+static int ingest_reader_uring(ingest_ring *r) {
+	struct io_uring ring;
+	struct io_uring_cqe *cqe;
+	unsigned long submitted = 0;
+	unsigned int inflight = 0;
+	int err = 0;
+
+	if (io_uring_queue_init(r->num_slots, &ring, 0) < 0) {
+		return 1;
+	}
+	while (r->framed < r->num_chunks && err == 0) {
+		ingest_slot *s;
+		off_t off;
+
+		pthread_mutex_lock(&r->lock);
+		while (submitted < r->num_chunks &&
+				!r->slots[submitted % r->num_slots].busy) {
+			struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+			s = &r->slots[submitted % r->num_slots];
+			io_uring_prep_read(sqe, r->fd, s->buf + r->chunk, r->chunk,
+					(off_t) submitted * r->chunk);
+			io_uring_sqe_set_data(sqe, s);
+			s->seq = submitted;
+			s->busy = 1;
+			submitted++;
+			inflight++;
+		}
+		if (inflight == 0) {
+			pthread_cond_wait(&r->free, &r->lock);
+			pthread_mutex_unlock(&r->lock);
+			continue;
+		}
+		pthread_mutex_unlock(&r->lock);
+
+		io_uring_submit(&ring);
+		if ((err = io_uring_wait_cqe(&ring, &cqe)) < 0) {
+			fprintf(stderr, "io_uring: %s\n", strerror(-err));
+			break;
+		}
+		s = io_uring_cqe_get_data(cqe);
+		off = (off_t) s->seq * r->chunk;
+		/* Short only at the end of the file */
+		if (cqe->res < 0 || (off + cqe->res != r->size &&
+					(size_t) cqe->res != r->chunk)) {
+			fprintf(stderr, "read at %ld: %s\n", (long) off,
+					cqe->res < 0 ? strerror(-cqe->res) : "short read");
+			err = -1;
+		}
+		s->len = cqe->res;
+		s->read = 1;
+		io_uring_cqe_seen(&ring, cqe);
+		inflight--;
+
+		while (err == 0 && r->framed < submitted &&
+				(s = &r->slots[r->framed % r->num_slots])->read) {
+			s->read = 0;
+			/* A slot that failed to frame is not handed on, as in
+			 * ingest_reader_pread() */
+			err = ingest_frame(r, s, r->framed + 1 == r->num_chunks);
+			if (err < 0) {
+				break;
+			}
+			ingest_push(r, r->framed);
+		}
+	}
+	while (inflight-- > 0 && io_uring_wait_cqe(&ring, &cqe) == 0) {
+		io_uring_cqe_seen(&ring, cqe);
+	}
+	io_uring_queue_exit(&ring);
+	return err;
+}
+#endif
+
+static int ingest_reader(ingest_ring *r, const char **name) {
+#ifdef JSMN_INGEST_URING
+	int err = ingest_reader_uring(r);
+
+	if (err != 1) {
+		*name = "io_uring";
+		return err;
+	}
+	/* Kernels before 5.6 and some container sandboxes refuse io_uring */
+#endif
+	*name = "pread";
+	return ingest_reader_pread(r);
+}
+
+static int ingest_pipeline(ingest_ring *r, int threads, const char **name) {
+	pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+	int i, n, err;
+
+	if (workers == NULL) {
+		return -1;
+	}
+	for (n = 0; n < threads; n++) {
+		if (pthread_create(&workers[n], NULL, ingest_worker, r) != 0) {
+			break;
+		}
+	}
+	err = n == 0 ? -1 : ingest_reader(r, name);
+
+	pthread_mutex_lock(&r->lock);
+	r->eof = 1;
+	pthread_cond_broadcast(&r->ready);
+	pthread_mutex_unlock(&r->lock);
+	for (i = 0; i < n; i++) {
+		pthread_join(workers[i], NULL);
+	}
+	free(workers);
+	return err;
+}
+
+/* Read-then-parse with one buffer */
+static int ingest_serial(ingest_ring *r) {
+	ingest_slot *s = &r->slots[0];
+	unsigned int num_tokens = 64;
+	jsmntok_t *tok = malloc(sizeof(*tok) * num_tokens);
+	unsigned long seq;
+	int err = tok == NULL ? -1 : 0;
+
+	for (seq = 0; seq < r->num_chunks && err == 0; seq++) {
+		err = ingest_read(r, s, seq);
+		if (err == 0) {
+			err = ingest_frame(r, s, seq + 1 == r->num_chunks);
+		}
+		if (err == 0) {
+			ingest_parse(s->buf + s->begin, s->end - s->begin, &tok,
+					&num_tokens, &r->count);
+		}
+	}
+	free(tok);
+	return err;
+}
+
+static void ingest_reset(ingest_ring *r) {
+	unsigned int i;
+
+	for (i = 0; i < r->num_slots; i++) {
+		r->slots[i].busy = 0;
+		r->slots[i].read = 0;
+	}
+	r->carry_len = 0;
+	r->next = 0;
+	r->framed = 0;
+	r->eof = 0;
+	memset(&r->count, 0, sizeof(r->count));
+}
+
+static void ingest_report(const char *label, const ingest_ring *r,
+		double secs) {
+	printf("%-24s %8.1f MB/s %10lu records %12lu tokens %6lu errors\n", label,
+			r->size / secs / 1e6, r->count.records, r->count.tokens,
+			r->count.errors);
+}
+
+int main(int argc, char *argv[]) {
+	ingest_ring r;
+	ingest_count serial;
+	const char *reader;
+	struct stat st;
+	char label[32];
+	int threads = 4;
+	int direct = 0;
+	unsigned int i;
+	double start;
+	int opt;
+
+	memset(&r, 0, sizeof(r));
+	r.num_slots = 8;
+	r.chunk = 1 << 20;
+	while ((opt = getopt(argc, argv, "t:n:b:d")) != -1) {
+		switch (opt) {
+			case 't': threads = atoi(optarg); break;
+			case 'n': r.num_slots = (unsigned int) atoi(optarg); break;
+			case 'b': r.chunk = (size_t) atoi(optarg) * 1024; break;
+			case 'd': direct = 1; break;
+			default: optind = argc + 1; break;
+		}
+	}
+	if (optind != argc - 1 || threads < 1 || r.num_slots < 2 ||
+			r.chunk < 4096 || r.chunk % 4096 != 0) {
+		fprintf(stderr, "usage: %s [-t threads] [-n buffers (2 or more)] "
+				"[-b KiB per buffer (multiple of 4)] [-d] file\n", argv[0]);
+		return 2;
+	}
+
+	r.fd = open(argv[optind], O_RDONLY);
+#ifdef O_DIRECT
+	if (direct && r.fd >= 0) {
+		close(r.fd);
+		r.fd = open(argv[optind], O_RDONLY | O_DIRECT);
+	}
+#endif
+	if (r.fd < 0 || fstat(r.fd, &st) < 0) {
+		fprintf(stderr, "%s: %s\n", argv[optind], strerror(errno));
+		return 1;
+	}
+	r.size = st.st_size;
+	r.num_chunks = (unsigned long) ((r.size + r.chunk - 1) / r.chunk);
+	r.slots = calloc(r.num_slots, sizeof(ingest_slot));
+	r.carry = malloc(r.chunk);
+	if (r.slots == NULL || r.carry == NULL) {
+		return 3;
+	}
+	for (i = 0; i < r.num_slots; i++) {
+		/* Block aligned for O_DIRECT */
+		if (posix_memalign((void **) &r.slots[i].buf, 4096, 2 * r.chunk)) {
+			return 3;
+		}
+	}
+	pthread_mutex_init(&r.lock, NULL);
+	pthread_cond_init(&r.ready, NULL);
+	pthread_cond_init(&r.free, NULL);
+
+	ingest_reset(&r);
+	start = ingest_now();
+	if (ingest_serial(&r) < 0) {
+		return 1;
+	}
+	ingest_report("serial", &r, ingest_now() - start);
+	serial = r.count;
+
+	ingest_reset(&r);
+	start = ingest_now();
+	if (ingest_pipeline(&r, threads, &reader) < 0) {
+		return 1;
+	}
+	sprintf(label, "pipeline %s %dt", reader, threads);
+	ingest_report(label, &r, ingest_now() - start);
+	if (memcmp(&serial, &r.count, sizeof(serial)) != 0) {
+		fprintf(stderr, "pipeline saw other records than serial\n");
+		return 1;
+	}
+
+	for (i = 0; i < r.num_slots; i++) {
+		free(r.slots[i].buf);
+	}
+	free(r.slots);
+	free(r.carry);
+	close(r.fd);
+	return 0;
+}
@@ -7,6 +7,56 @@
 extern "C" {
 #endif
 
+/**
+ * Build configuration. jsmn can be used either as a library (compile jsmn.c
+ * and link with it) or as a single header. All switches below are plain
+ * preprocessor definitions, so in the single-header mode every translation
+ * unit may pick its own set of them:
+ * 	o JSMN_STATIC - include the implementation with static (inline) linkage,
+ * 	  so the compiler can inline the parser into the calling code
+ * 	o JSMN_IMPLEMENTATION - include the implementation with external
+ * 	  linkage, this is what jsmn.c does
+ * 	o JSMN_STRICT - make jsmn_init() select strict mode, which accepts only
+ * 	  valid JSON primitives (see jsmn_parser.strict)
+ * 	o JSMN_PARENT_LINKS - keep index of the parent token in each token
+ * 	o JSMN_COMPACT - store token fields in 16 bits, limits input to
+ * 	  JSMN_POS_MAX bytes
+ */
+#ifndef JSMN_INLINE
+#if defined(__GNUC__)
+#define JSMN_INLINE __inline__
+#elif defined(_MSC_VER)
+#define JSMN_INLINE __inline
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define JSMN_INLINE inline
+#else
+#define JSMN_INLINE
+#endif
+#endif
+
+#ifndef JSMN_FORCEINLINE
+#if defined(__GNUC__)
+#define JSMN_FORCEINLINE __inline__ __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define JSMN_FORCEINLINE __forceinline
+#else
+#define JSMN_FORCEINLINE JSMN_INLINE
+#endif
+#endif
+
+#ifdef JSMN_STATIC
+#define JSMN_API static JSMN_INLINE
+#else
+#define JSMN_API extern
+#endif
+
+#ifdef JSMN_COMPACT
+typedef short jsmnint_t;
+#define JSMN_POS_MAX 32767
+#else
+typedef int jsmnint_t;
+#endif
+
 /**
  * JSON type identifier. Basic types are:
  * 	o Object
@@ -38,15 +88,87 @@ enum jsmnerr {
  * end		end position in JSON data string
  */
 typedef struct {
+#ifdef JSMN_COMPACT
+	unsigned char type;
+#else
 	jsmntype_t type;
-	int start;
-	int end;
-	int size;
+#endif
+	jsmnint_t start;
+	jsmnint_t end;
+	jsmnint_t size;
 #ifdef JSMN_PARENT_LINKS
-	int parent;
+	jsmnint_t parent;
 #endif
 } jsmntok_t;
 
+/**
+ * Tokens as a structure of arrays, for code that looks at one field of many
+ * tokens at a time (see jsmn_parse_soa() and jsmn_soa.h). Element i of each
+ * array belongs to token i. Parents are always kept, with or without
+ * JSMN_PARENT_LINKS.
+ */
+typedef struct {
+	unsigned char *type;
+	jsmnint_t *start;
+	jsmnint_t *end;
+	jsmnint_t *size;
+	jsmnint_t *parent;
+} jsmn_soa;
+
+#define JSMN_KEYSET_MAX 64
+
+/**
+ * Set of object member names to keep. When jsmn_parser.keys points to a set,
+ * members of any object whose name is not in it get no tokens at all: their
+ * values are skipped by matching quotes and brackets only (so they are not
+ * validated), and the object size counts the kept members. Names are
+ * compared as they are written in JSON, escapes included.
+ *
+ * Names are ordered by length and then by bytes for a binary search, and
+ * lenmask has bit (length % 32) set for every name, so most unknown keys are
+ * rejected without comparing any bytes. Fill it with jsmn_keyset_init().
+ */
+typedef struct {
+	const char *names[JSMN_KEYSET_MAX];
+	unsigned int lengths[JSMN_KEYSET_MAX];
+	unsigned int num_names;
+	unsigned long lenmask;
+} jsmn_keyset;
+
+/**
+ * Slot of a jsmn_intern hash table.
+ */
+typedef struct {
+	unsigned int hash; /* FNV-1a hash of the name */
+	unsigned int len; /* length of the name */
+	unsigned int name; /* offset of the name in jsmn_intern.names */
+	int id; /* id of the name, -1 for an empty slot */
+} jsmn_intern_slot;
+
+/**
+ * Key interning table. When jsmn_parser.intern points to a table, every
+ * string object key gets a small integer id, the same for the same name in
+ * all documents parsed with the table, and ids[i] receives the id of key
+ * token i (other entries of ids are not touched). Ids are given out from 0
+ * in the order names are first seen. The key hash is computed while the key
+ * is scanned, so known keys cost one probe and one comparison.
+ *
+ * The table never allocates: slots and a buffer for copies of the names are
+ * provided by the caller. Keys that do not fit get id -1.
+ */
+typedef struct {
+	jsmn_intern_slot *slots; /* hash table, num_slots is a power of two */
+	unsigned int num_slots;
+	char *names; /* copies of the interned names */
+	unsigned int names_size;
+	unsigned int names_len;
+	int num_ids; /* number of interned names */
+	int *ids; /* key ids by token index, may be NULL */
+} jsmn_intern;
+
+#define JSMN_FNV_BASIS 2166136261U
+#define JSMN_FNV_PRIME 16777619U
+
 /**
  * JSON parser. Contains an array of token blocks available. Also stores
  * the string being parsed now and current position in that string
@@ -55,22 +177,1055 @@ typedef struct {
 	unsigned int pos; /* offset in the JSON string */
 	unsigned int toknext; /* next token to allocate */
 	int toksuper; /* superior token node, e.g parent object or array */
+	int strict; /* non-zero to accept only valid JSON primitives */
+	unsigned int errpos; /* offset where the last error was found */
+	const jsmn_keyset *keys; /* object members to keep, NULL for all */
+	jsmn_intern *intern; /* table for key ids, NULL for none */
 } jsmn_parser;
 
 /**
- * Create JSON parser over an array of tokens
+ * Parse error description, see jsmn_get_error().
+ * pos		offset of the character where parsing failed
+ * line		line number of pos, starting from 1
+ * col		column (in bytes) of pos, starting from 1
+ * token	index of the last token stored before the error, -1 if none
+ */
+typedef struct {
+	unsigned int pos;
+	unsigned int line;
+	unsigned int col;
+	int token;
+} jsmn_error;
+
+#ifndef JSMN_SNAPSHOT_DEPTH
+#define JSMN_SNAPSHOT_DEPTH 64
+#endif
+
+/**
+ * Parser state saved by jsmn_save(). Tokens before parser.toknext do not
+ * change any more, except end and size of the ones parsing can go back to:
+ * unclosed objects and arrays, keys around the position and the last token.
+ * Those are kept here, at most JSMN_SNAPSHOT_DEPTH of them (two per level of
+ * nested objects).
+ */
+typedef struct {
+	jsmn_parser parser;
+	unsigned int depth; /* number of saved tokens */
+	int index[JSMN_SNAPSHOT_DEPTH];
+	jsmnint_t end[JSMN_SNAPSHOT_DEPTH];
+	jsmnint_t size[JSMN_SNAPSHOT_DEPTH];
+} jsmn_snapshot;
+
+/**
+ * Create JSON parser over an array of tokens. Strict mode is enabled if jsmn
+ * was built with JSMN_STRICT, set parser->strict to override it.
  */
-void jsmn_init(jsmn_parser *parser);
+JSMN_API void jsmn_init(jsmn_parser *parser);
+
+/**
+ * Prepares a set of num_names member names (at most JSMN_KEYSET_MAX, no
+ * duplicates) for jsmn_parser.keys. The names are not copied. Returns 0 or
+ * JSMN_ERROR_INVAL.
+ */
+JSMN_API int jsmn_keyset_init(jsmn_keyset *set, const char *const *names,
+		unsigned int num_names);
+
+/**
+ * Returns the index in set->names of the name equal to len bytes of key, or
+ * -1 if there is none.
+ */
+JSMN_API int jsmn_keyset_find(const jsmn_keyset *set, const char *key,
+		unsigned int len);
+
+/**
+ * Sets up an empty interning table over num_slots slots (a power of two, at
+ * least 4) and a names_size bytes buffer for the names. Returns 0, or
+ * JSMN_ERROR_INVAL for another number of slots, and then the table gives
+ * every key id -1.
+ */
+JSMN_API int jsmn_intern_init(jsmn_intern *in, jsmn_intern_slot *slots,
+		unsigned int num_slots, char *names, unsigned int names_size);
+
+/**
+ * Returns the id of len bytes of key, interning it first if it is new, or
+ * -1 if the table is full. Use it to learn ids of the names to look for.
+ */
+JSMN_API int jsmn_intern_key(jsmn_intern *in, const char *key,
+		unsigned int len);
 
 /**
  * Run JSON parser. It parses a JSON data string into and array of tokens, each describing
  * a single JSON object.
  */
-int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
+JSMN_API int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 		jsmntok_t *tokens, unsigned int num_tokens);
 
+/**
+ * Same as jsmn_parse(), but stores tokens into the arrays of soa, which have
+ * room for num_tokens tokens each. Enclosing tokens are found through the
+ * parent array, so the tokens are the ones a JSMN_PARENT_LINKS build of
+ * jsmn_parse() gives, in any build.
+ */
+JSMN_API int jsmn_parse_soa(jsmn_parser *parser, const char *js, size_t len,
+		const jsmn_soa *soa, unsigned int num_tokens);
+
+/**
+ * Describes where the last jsmn_parse() call failed. Line and column are only
+ * counted here, so errors cost nothing extra while parsing.
+ */
+JSMN_API void jsmn_get_error(const jsmn_parser *parser, const char *js,
+		jsmn_error *err);
+
+/**
+ * Skips the broken record after a failed jsmn_parse(), so the following
+ * records can be parsed without starting over. Records are top-level values
+ * separated by newlines (e.g. NDJSON): tokens of the unfinished record are
+ * dropped and parsing continues on the line after the error. Returns the
+ * number of tokens kept.
+ */
+JSMN_API int jsmn_recover(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens);
+
+/**
+ * Saves the state of a parse stopped by jsmn_parse() (returning a count or
+ * JSMN_ERROR_PART), so it can go back there with jsmn_restore() after a
+ * later call fails or to try other input that starts the same way, instead
+ * of parsing from the start again. With JSMN_PARENT_LINKS this costs a walk
+ * up the parents of the last token, otherwise a scan of the tokens stored so
+ * far. Returns 0 or JSMN_ERROR_NOMEM if more than JSMN_SNAPSHOT_DEPTH tokens
+ * are to be kept.
+ */
+JSMN_API int jsmn_save(const jsmn_parser *parser, const jsmntok_t *tokens,
+		jsmn_snapshot *snap);
+
+/**
+ * Puts parser and tokens back to the state saved in snap. Tokens from
+ * snap->parser.toknext on are free again, whatever was parsed into them
+ * since. Change parser->strict afterwards to continue in another mode. Keys
+ * interned since stay in the interning table.
+ */
+JSMN_API void jsmn_restore(jsmn_parser *parser, jsmntok_t *tokens,
+		const jsmn_snapshot *snap);
+
 #ifdef __cplusplus
 }
 #endif
 
 #endif /* __JSMN_H_ */
+
+#if (defined(JSMN_STATIC) || defined(JSMN_IMPLEMENTATION)) && \
+	!defined(__JSMN_IMPL_H_)
+#define __JSMN_IMPL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Remembers where parsing failed and returns the error code.
+ */
+static JSMN_INLINE int jsmn_fail(jsmn_parser *parser, int err) {
+	parser->errpos = parser->pos;
+	return err;
+}
+
+/*
+ * Character classes, shared by the parsing loops. The low bits of an entry
+ * are what the main loop dispatches on, the high bits are tested by the
+ * string and primitive scans, so every byte costs one table load instead of
+ * a chain of comparisons.
+ */
+#define JSMN_CH_OTHER 0 /* anything else: primitive, or error when strict */
+#define JSMN_CH_OPEN 1 /* { [ */
+#define JSMN_CH_CLOSE 2 /* } ] */
+#define JSMN_CH_QUOTE 3 /* " */
+#define JSMN_CH_SPACE 4 /* whitespace */
+#define JSMN_CH_COLON 5 /* : */
+#define JSMN_CH_COMMA 6 /* , */
+#define JSMN_CH_PRIM 7 /* starts a primitive in strict mode: - 0-9 t f n */
+#define JSMN_CH_CODE 0x07
+#define JSMN_CH_DELIM 0x08 /* ends a primitive: whitespace , ] } */
+#define JSMN_CH_HEX 0x10 /* 0-9 A-F a-f */
+#define JSMN_CH_CTRL 0x20 /* not allowed in a primitive: control, non-ASCII */
+#define JSMN_CH_STOP 0x40 /* ends a run of plain string bytes: quote, backslash, NUL */
+#define JSMN_CH_KEYEND 0x80 /* also ends a primitive in lenient mode: : */
+
+static const unsigned char jsmn_chars[256] = {
+	0x60, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 0..7 */
+	0x20, 0x0c, 0x0c, 0x20, 0x20, 0x0c, 0x20, 0x20, /* 8..15 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 16..23 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 24..31 */
+	0x0c, 0x00, 0x43, 0x00, 0x00, 0x00, 0x00, 0x00, /*   ! " # $ % & ' */
+	0x00, 0x00, 0x00, 0x00, 0x0e, 0x07, 0x00, 0x00, /* ( ) * + , - . / */
+	0x17, 0x17, 0x17, 0x17, 0x17, 0x17, 0x17, 0x17, /* 0 1 2 3 4 5 6 7 */
+	0x17, 0x17, 0x85, 0x00, 0x00, 0x00, 0x00, 0x00, /* 8 9 : ; < = > ? */
+	0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, /* @ A B C D E F G */
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* H I J K L M N O */
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* P Q R S T U V W */
+	0x00, 0x00, 0x00, 0x01, 0x40, 0x0a, 0x00, 0x00, /* X Y Z [ \ ] ^ _ */
+	0x00, 0x10, 0x10, 0x10, 0x10, 0x10, 0x17, 0x00, /* ` a b c d e f g */
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, /* h i j k l m n o */
+	0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, /* p q r s t u v w */
+	0x00, 0x00, 0x00, 0x01, 0x00, 0x0a, 0x00, 0x20, /* x y z { | } ~ DEL */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 128..135 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 136..143 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 144..151 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 152..159 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 160..167 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 168..175 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 176..183 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 184..191 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 192..199 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 200..207 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 208..215 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 216..223 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 224..231 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 232..239 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, /* 240..247 */
+	0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20  /* 248..255 */
+};
+
+#define jsmn_class(c) (jsmn_chars[(unsigned char) (c)])
+
+/**
+ * Finds the end of a JSON primitive, parser->pos is left at its last byte.
+ */
+static JSMN_FORCEINLINE int jsmn_parse_primitive(jsmn_parser *parser,
+		const char *js, size_t len, const int strict) {
+	int start;
+
+	start = parser->pos;
+
+	for (; parser->pos < len; parser->pos++) {
+		/* In strict mode primitive must be followed by "," or "}" or "]" */
+		unsigned char k = jsmn_class(js[parser->pos]) & (strict ?
+				JSMN_CH_DELIM | JSMN_CH_CTRL :
+				JSMN_CH_DELIM | JSMN_CH_CTRL | JSMN_CH_KEYEND);
+		if (k == 0) {
+			continue;
+		}
+		if (k != JSMN_CH_CTRL) {
+			goto found;
+		}
+		if (js[parser->pos] == '\0') {
+			break;
+		}
+		parser->errpos = parser->pos;
+		parser->pos = start;
+		return JSMN_ERROR_INVAL;
+	}
+	if (strict) {
+		/* In strict mode primitive must be followed by a comma/object/array */
+		parser->errpos = parser->pos;
+		parser->pos = start;
+		return JSMN_ERROR_PART;
+	}
+
+found:
+	parser->pos--;
+	return 0;
+}
+
+/**
+ * Finds the end of a JSON string, parser->pos is left at the closing quote.
+ * With hashing set, *hash also receives the FNV-1a hash of the string
+ * contents (as written, escapes included), computed in the same scan.
+ */
+static JSMN_FORCEINLINE int jsmn_parse_string_impl(jsmn_parser *parser,
+		const char *js, size_t len, unsigned int *hash, const int hashing) {
+	unsigned int h = JSMN_FNV_BASIS;
+
+	int start = parser->pos;
+
+	parser->pos++;
+
+	/* Skip starting quote */
+	for (; parser->pos < len; parser->pos++) {
+		char c = js[parser->pos];
+
+		/* Plain bytes only need hashing */
+		if (!(jsmn_class(c) & JSMN_CH_STOP)) {
+			if (hashing) {
+				h = (h ^ (unsigned char) c) * JSMN_FNV_PRIME;
+			}
+			continue;
+		}
+		if (c == '\0') {
+			break;
+		}
+
+		/* Quote: end of string */
+		if (c == '\"') {
+			if (hashing) {
+				*hash = h;
+			}
+			return 0;
+		}
+		if (hashing) {
+			h = (h ^ (unsigned char) c) * JSMN_FNV_PRIME;
+		}
+
+		/* Backslash: Quoted symbol expected */
+		if (parser->pos + 1 < len) {
+			int i;
+			parser->pos++;
+			switch (js[parser->pos]) {
+				/* Allowed escaped symbols */
+				case '\"': case '/' : case '\\' : case 'b' :
+				case 'f' : case 'r' : case 'n'  : case 't' :
+					break;
+				/* Allows escaped symbol \uXXXX */
+				case 'u':
+					parser->pos++;
+					for(i = 0; i < 4 && parser->pos < len && js[parser->pos] != '\0'; i++) {
+						/* If it isn't a hex character we have an error */
+						if (!(jsmn_class(js[parser->pos]) & JSMN_CH_HEX)) {
+							parser->errpos = parser->pos;
+							parser->pos = start;
+							return JSMN_ERROR_INVAL;
+						}
+						parser->pos++;
+					}
+					parser->pos--;
+					break;
+				/* Unexpected symbol */
+				default:
+					parser->errpos = parser->pos;
+					parser->pos = start;
+					return JSMN_ERROR_INVAL;
+			}
+			if (hashing) {
+				/* The backslash is hashed already, now the rest of it */
+				for (i = parser->pos - 1; js[i] != '\\'; i--);
+				for (i++; i <= (int) parser->pos; i++) {
+					h = (h ^ (unsigned char) js[i]) * JSMN_FNV_PRIME;
+				}
+			}
+		}
+	}
+	parser->errpos = parser->pos;
+	parser->pos = start;
+	return JSMN_ERROR_PART;
+}
+
+static int jsmn_parse_string(jsmn_parser *parser, const char *js,
+		size_t len) {
+	return jsmn_parse_string_impl(parser, js, len, NULL, 0);
+}
+
+static int jsmn_parse_string_hashed(jsmn_parser *parser, const char *js,
+		size_t len, unsigned int *hash) {
+	return jsmn_parse_string_impl(parser, js, len, hash, 1);
+}
+
+/**
+ * Finds or adds len bytes of key with the given hash, see jsmn_intern_key().
+ */
+static int jsmn_intern_insert(jsmn_intern *in, const char *key,
+		unsigned int len, unsigned int hash) {
+	unsigned int mask = in->num_slots - 1;
+	unsigned int i, k, n;
+	jsmn_intern_slot *slot = NULL;
+
+	/* Bounded, so a table without an empty slot cannot loop forever */
+	for (i = hash & mask, n = 0; n < in->num_slots; i = (i + 1) & mask, n++) {
+		slot = &in->slots[i];
+		if (slot->id < 0) {
+			break;
+		}
+		if (slot->hash == hash && slot->len == len) {
+			for (k = 0; k < len && in->names[slot->name + k] == key[k]; k++);
+			if (k == len) {
+				return slot->id;
+			}
+		}
+	}
+	if (n == in->num_slots) {
+		return -1;
+	}
+	/* Keep a quarter of the slots empty for short probes */
+	if ((unsigned int) in->num_ids + 1 > in->num_slots - in->num_slots / 4 ||
+			len > in->names_size - in->names_len) {
+		return -1;
+	}
+	for (k = 0; k < len; k++) {
+		in->names[in->names_len + k] = key[k];
+	}
+	slot->hash = hash;
+	slot->len = len;
+	slot->name = in->names_len;
+	slot->id = in->num_ids++;
+	in->names_len += len;
+	return slot->id;
+}
+
+/**
+ * Stores the id of the key token tokens[i]. hash is the hash of the key if
+ * it was computed while the token was scanned, i.e. if hashtok == i.
+ */
+static void jsmn_intern_token(jsmn_intern *in, const char *js, int start,
+		int end, int i, unsigned int hash, int hashtok) {
+	unsigned int len = (unsigned int) (end - start);
+	unsigned int k;
+	int id;
+
+	if (hashtok != i) {
+		hash = JSMN_FNV_BASIS;
+		for (k = 0; k < len; k++) {
+			hash = (hash ^ (unsigned char) js[start + k]) * JSMN_FNV_PRIME;
+		}
+	}
+	id = jsmn_intern_insert(in, js + start, len, hash);
+	if (in->ids != NULL) {
+		in->ids[i] = id;
+	}
+}
+
+JSMN_API int jsmn_keyset_find(const jsmn_keyset *set, const char *key,
+		unsigned int len) {
+	unsigned int lo = 0;
+	unsigned int hi = set->num_names;
+	unsigned int i;
+
+	if (!(set->lenmask & (1UL << (len % 32)))) {
+		return -1;
+	}
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+		const char *name = set->names[mid];
+		int cmp = 0;
+
+		if (len != set->lengths[mid]) {
+			cmp = len < set->lengths[mid] ? -1 : 1;
+		}
+		for (i = 0; cmp == 0 && i < len; i++) {
+			cmp = (unsigned char) key[i] - (unsigned char) name[i];
+		}
+		if (cmp == 0) {
+			return (int) mid;
+		}
+		if (cmp < 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Skips the value of an object member whose name starts at the quote at
+ * offset start and ends at parser->pos, if the name is not in parser->keys.
+ * Returns 1 when the member was skipped (parser->pos is then at the last
+ * character of the value), 0 if the string is not a key or the key is kept.
+ */
+static int jsmn_skip_member(jsmn_parser *parser, const char *js, size_t len,
+		unsigned int start) {
+	unsigned int pos = parser->pos + 1;
+	int depth = 0;
+
+	while (pos < len && (js[pos] == ' ' || js[pos] == '\t' ||
+				js[pos] == '\n' || js[pos] == '\r')) {
+		pos++;
+	}
+	/* Only a string followed by a colon is a key */
+	if (pos >= len || js[pos] != ':' || jsmn_keyset_find(parser->keys,
+				js + start + 1, parser->pos - start - 1) >= 0) {
+		return 0;
+	}
+	for (pos++; pos < len && js[pos] != '\0'; pos++) {
+		switch (js[pos]) {
+			case '\t': case '\r': case '\n': case ' ':
+				break;
+			case '\"':
+				for (pos++; pos < len && js[pos] != '\0' && js[pos] != '\"';
+						pos++) {
+					if (js[pos] == '\\') {
+						pos++;
+					}
+				}
+				if (pos >= len || js[pos] == '\0') {
+					goto partial;
+				}
+				if (depth == 0) {
+					parser->pos = pos;
+					return 1;
+				}
+				break;
+			case '{': case '[':
+				depth++;
+				break;
+			case '}': case ']':
+				if (depth == 0) {
+					goto invalid;
+				}
+				if (--depth == 0) {
+					parser->pos = pos;
+					return 1;
+				}
+				break;
+			case ',': case ':':
+				if (depth == 0) {
+					goto invalid;
+				}
+				break;
+			default:
+				if (depth == 0) {
+					/* Primitive, up to the next delimiter */
+					for (; pos < len && js[pos] != '\0'; pos++) {
+						switch (js[pos]) {
+							case '\t': case '\r': case '\n': case ' ':
+							case ',': case ']': case '}': case ':':
+								parser->pos = pos - 1;
+								return 1;
+						}
+					}
+					goto partial;
+				}
+				break;
+		}
+	}
+partial:
+	parser->errpos = pos;
+	parser->pos = start;
+	return JSMN_ERROR_PART;
+invalid:
+	parser->errpos = pos;
+	parser->pos = start;
+	return JSMN_ERROR_INVAL;
+}
+
+/*
+ * Token fields. The parser is expanded separately for tokens in an array of
+ * jsmntok_t and in a jsmn_soa, soa_mode selects at compile time which of
+ * tokens and soa is used. Parents exist in soa and with JSMN_PARENT_LINKS,
+ * JSMN_LINKS || soa_mode guards every use of them.
+ *
+ * jsmn.hpp expands jsmn_alloc_token() and jsmn_parse_impl() for other token
+ * structures: it defines JSMN_LOOP_TEMPLATE to make them templates over the
+ * token and soa types, with JSMN_LINKS, JSMN_TOK_PARENT and JSMN_LOOP_POS_MAX
+ * for those types, and JSMN_LOOP() to name the expansion for jsmntok_t.
+ */
+#define JSMN_TOK_TYPE(i) \
+	(soa_mode ? (jsmntype_t) soa->type[i] : (jsmntype_t) tokens[i].type)
+#define JSMN_TOK_START(i) (*(soa_mode ? &soa->start[i] : &tokens[i].start))
+#define JSMN_TOK_END(i) (*(soa_mode ? &soa->end[i] : &tokens[i].end))
+#define JSMN_TOK_SIZE(i) (*(soa_mode ? &soa->size[i] : &tokens[i].size))
+#ifndef JSMN_LOOP_TEMPLATE
+#define JSMN_LOOP_TEMPLATE
+#define JSMN_LOOP(f) f
+#define JSMN_LOOP_TOKEN jsmntok_t
+#define JSMN_LOOP_SOA jsmn_soa
+#ifdef JSMN_PARENT_LINKS
+#define JSMN_LINKS 1
+#define JSMN_TOK_PARENT(i) (*(soa_mode ? &soa->parent[i] : &tokens[i].parent))
+#else
+#define JSMN_LINKS 0
+#define JSMN_TOK_PARENT(i) (soa->parent[i])
+#endif
+#ifdef JSMN_COMPACT
+#define JSMN_LOOP_POS_MAX JSMN_POS_MAX
+#endif
+#endif
+
+#ifdef __cplusplus
+} /* templates cannot have C linkage */
+#endif
+
+/**
+ * Allocates a fresh unused token from the token pool and fills it, the
+ * current superior token becomes its parent. Returns its index or -1.
+ */
+JSMN_LOOP_TEMPLATE
+static JSMN_FORCEINLINE int jsmn_alloc_token(jsmn_parser *parser,
+		JSMN_LOOP_TOKEN *tokens, const JSMN_LOOP_SOA *soa, size_t num_tokens,
+		jsmntype_t type, int start, int end, const int soa_mode) {
+	int i;
+
+	if (parser->toknext >= num_tokens) {
+		return -1;
+	}
+	i = parser->toknext++;
+	if (soa_mode) {
+		soa->type[i] = (unsigned char) type;
+	} else {
+		tokens[i].type = type;
+	}
+	JSMN_TOK_START(i) = start;
+	JSMN_TOK_END(i) = end;
+	JSMN_TOK_SIZE(i) = 0;
+	if (JSMN_LINKS || soa_mode) {
+		JSMN_TOK_PARENT(i) = parser->toksuper;
+	}
+	return i;
+}
+
+/**
+ * Parsing loop. It is expanded separately for strict and non-strict mode,
+ * so the strict checks are resolved at compile time, and for both token
+ * layouts (see JSMN_TOK_TYPE).
+ */
+JSMN_LOOP_TEMPLATE
+static JSMN_FORCEINLINE int jsmn_parse_impl(jsmn_parser *parser,
+		const char *js, size_t len, JSMN_LOOP_TOKEN *tokens,
+		const JSMN_LOOP_SOA *soa, unsigned int num_tokens, const int strict,
+		const int soa_mode) {
+	int r;
+	int i;
+	int count = parser->toknext;
+	int store = soa_mode || tokens != NULL;
+	unsigned int hash = 0;
+	int hashtok = -1; /* token whose key hash is in hash */
+
+#ifdef JSMN_LOOP_POS_MAX
+	/* Token offsets would not fit into the token fields */
+	if (len > JSMN_LOOP_POS_MAX) {
+		return jsmn_fail(parser, JSMN_ERROR_NOMEM);
+	}
+#endif
+
+	for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
+		char c;
+		jsmntype_t type;
+
+		c = js[parser->pos];
+		switch (jsmn_class(c) & JSMN_CH_CODE) {
+			case JSMN_CH_OPEN:
+				count++;
+				if (!store) {
+					break;
+				}
+				i = jsmn_alloc_token(parser, tokens, soa, num_tokens,
+						c == '{' ? JSMN_OBJECT : JSMN_ARRAY, parser->pos, -1,
+						soa_mode);
+				if (i < 0)
+					return jsmn_fail(parser, JSMN_ERROR_NOMEM);
+				if (parser->toksuper != -1) {
+					JSMN_TOK_SIZE(parser->toksuper)++;
+				}
+				parser->toksuper = i;
+				break;
+			case JSMN_CH_CLOSE:
+				if (!store)
+					break;
+				type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
+				if (JSMN_LINKS || soa_mode) {
+					if (parser->toknext < 1) {
+						return jsmn_fail(parser, JSMN_ERROR_INVAL);
+					}
+					i = parser->toknext - 1;
+					for (;;) {
+						if (JSMN_TOK_START(i) != -1 && JSMN_TOK_END(i) == -1) {
+							if (JSMN_TOK_TYPE(i) != type) {
+								return jsmn_fail(parser, JSMN_ERROR_INVAL);
+							}
+							JSMN_TOK_END(i) = parser->pos + 1;
+							parser->toksuper = JSMN_TOK_PARENT(i);
+							break;
+						}
+						if (JSMN_TOK_PARENT(i) == -1) {
+							if(JSMN_TOK_TYPE(i) != type || parser->toksuper == -1) {
+								return jsmn_fail(parser, JSMN_ERROR_INVAL);
+							}
+							break;
+						}
+						i = JSMN_TOK_PARENT(i);
+					}
+					break;
+				}
+				for (i = parser->toknext - 1; i >= 0; i--) {
+					if (JSMN_TOK_START(i) != -1 && JSMN_TOK_END(i) == -1) {
+						if (JSMN_TOK_TYPE(i) != type) {
+							return jsmn_fail(parser, JSMN_ERROR_INVAL);
+						}
+						parser->toksuper = -1;
+						JSMN_TOK_END(i) = parser->pos + 1;
+						break;
+					}
+				}
+				/* Error if unmatched closing bracket */
+				if (i == -1) return jsmn_fail(parser, JSMN_ERROR_INVAL);
+				for (; i >= 0; i--) {
+					if (JSMN_TOK_START(i) != -1 && JSMN_TOK_END(i) == -1) {
+						parser->toksuper = i;
+						break;
+					}
+				}
+				break;
+			case JSMN_CH_QUOTE:
+				i = parser->pos;
+				/* Scan first, unwanted members get no tokens at all */
+				if (parser->intern != NULL) {
+					r = jsmn_parse_string_hashed(parser, js, len, &hash);
+				} else {
+					r = jsmn_parse_string(parser, js, len);
+				}
+				if (r < 0) return r;
+				/* hash is of this string now, whatever hashtok named */
+				hashtok = -1;
+				if (parser->keys != NULL) {
+					r = jsmn_skip_member(parser, js, len, i);
+					if (r < 0) return r;
+					if (r > 0) break;
+				}
+				if (store) {
+					hashtok = parser->toknext;
+					if (jsmn_alloc_token(parser, tokens, soa, num_tokens,
+								JSMN_STRING, i + 1, parser->pos, soa_mode) < 0) {
+						parser->pos = i;
+						return jsmn_fail(parser, JSMN_ERROR_NOMEM);
+					}
+				}
+				count++;
+				if (parser->toksuper != -1 && store)
+					JSMN_TOK_SIZE(parser->toksuper)++;
+				break;
+			case JSMN_CH_SPACE:
+				break;
+			case JSMN_CH_COLON:
+				parser->toksuper = parser->toknext - 1;
+				if (parser->intern != NULL && store &&
+						parser->toksuper != -1 &&
+						JSMN_TOK_TYPE(parser->toksuper) == JSMN_STRING) {
+					jsmn_intern_token(parser->intern, js,
+							JSMN_TOK_START(parser->toksuper),
+							JSMN_TOK_END(parser->toksuper), parser->toksuper,
+							hash, hashtok);
+				}
+				break;
+			case JSMN_CH_COMMA:
+				if (store && parser->toksuper != -1 &&
+						JSMN_TOK_TYPE(parser->toksuper) != JSMN_ARRAY &&
+						JSMN_TOK_TYPE(parser->toksuper) != JSMN_OBJECT) {
+					if (JSMN_LINKS || soa_mode) {
+						parser->toksuper = JSMN_TOK_PARENT(parser->toksuper);
+						break;
+					}
+					for (i = parser->toknext - 1; i >= 0; i--) {
+						type = JSMN_TOK_TYPE(i);
+						if (type == JSMN_ARRAY || type == JSMN_OBJECT) {
+							if (JSMN_TOK_START(i) != -1 && JSMN_TOK_END(i) == -1) {
+								parser->toksuper = i;
+								break;
+							}
+						}
+					}
+				}
+				break;
+			/* In strict mode primitives are: numbers and booleans */
+			case JSMN_CH_PRIM:
+				/* And they must not be keys of the object */
+				if (strict && store && parser->toksuper != -1) {
+					type = JSMN_TOK_TYPE(parser->toksuper);
+					if (type == JSMN_OBJECT || (type == JSMN_STRING &&
+								JSMN_TOK_SIZE(parser->toksuper) != 0)) {
+						return jsmn_fail(parser, JSMN_ERROR_INVAL);
+					}
+				}
+				goto primitive;
+			default:
+				/* Unexpected char in strict mode */
+				if (strict) {
+					return jsmn_fail(parser, JSMN_ERROR_INVAL);
+				}
+				/* In non-strict mode every unquoted value is a primitive */
+primitive:
+				i = parser->pos;
+				r = jsmn_parse_primitive(parser, js, len, strict);
+				if (r < 0) return r;
+				if (store) {
+					if (jsmn_alloc_token(parser, tokens, soa, num_tokens,
+								JSMN_PRIMITIVE, i, parser->pos + 1, soa_mode) < 0) {
+						parser->pos = i;
+						return jsmn_fail(parser, JSMN_ERROR_NOMEM);
+					}
+				}
+				count++;
+				if (parser->toksuper != -1 && store)
+					JSMN_TOK_SIZE(parser->toksuper)++;
+				break;
+		}
+	}
+
+	if (store) {
+		for (i = parser->toknext - 1; i >= 0; i--) {
+			/* Unmatched opened object or array */
+			if (JSMN_TOK_START(i) != -1 && JSMN_TOK_END(i) == -1) {
+				return jsmn_fail(parser, JSMN_ERROR_PART);
+			}
+		}
+	}
+
+	return count;
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static int jsmn_parse_strict(jsmn_parser *parser, const char *js,
+		size_t len, jsmntok_t *tokens, unsigned int num_tokens) {
+	return JSMN_LOOP(jsmn_parse_impl)(parser, js, len, tokens, NULL,
+			num_tokens, 1, 0);
+}
+
+static int jsmn_parse_lenient(jsmn_parser *parser, const char *js,
+		size_t len, jsmntok_t *tokens, unsigned int num_tokens) {
+	return JSMN_LOOP(jsmn_parse_impl)(parser, js, len, tokens, NULL,
+			num_tokens, 0, 0);
+}
+
+static int jsmn_parse_soa_strict(jsmn_parser *parser, const char *js,
+		size_t len, const jsmn_soa *soa, unsigned int num_tokens) {
+	return JSMN_LOOP(jsmn_parse_impl)(parser, js, len, NULL, soa,
+			num_tokens, 1, 1);
+}
+
+static int jsmn_parse_soa_lenient(jsmn_parser *parser, const char *js,
+		size_t len, const jsmn_soa *soa, unsigned int num_tokens) {
+	return JSMN_LOOP(jsmn_parse_impl)(parser, js, len, NULL, soa,
+			num_tokens, 0, 1);
+}
+
+/**
+ * Parse JSON string and fill tokens.
+ */
+JSMN_API int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, unsigned int num_tokens) {
+	if (parser->strict) {
+		return jsmn_parse_strict(parser, js, len, tokens, num_tokens);
+	}
+	return jsmn_parse_lenient(parser, js, len, tokens, num_tokens);
+}
+
+JSMN_API int jsmn_parse_soa(jsmn_parser *parser, const char *js, size_t len,
+		const jsmn_soa *soa, unsigned int num_tokens) {
+	if (parser->strict) {
+		return jsmn_parse_soa_strict(parser, js, len, soa, num_tokens);
+	}
+	return jsmn_parse_soa_lenient(parser, js, len, soa, num_tokens);
+}
+
+/**
+ * Creates a new parser based over a given  buffer with an array of tokens
+ * available.
+ */
+JSMN_API void jsmn_init(jsmn_parser *parser) {
+	parser->pos = 0;
+	parser->toknext = 0;
+	parser->toksuper = -1;
+	parser->errpos = 0;
+	parser->keys = NULL;
+	parser->intern = NULL;
+#ifdef JSMN_STRICT
+	parser->strict = 1;
+#else
+	parser->strict = 0;
+#endif
+}
+
+JSMN_API int jsmn_intern_init(jsmn_intern *in, jsmn_intern_slot *slots,
+		unsigned int num_slots, char *names, unsigned int names_size) {
+	unsigned int i;
+	/* With fewer slots the quarter kept empty would be none */
+	int valid = num_slots >= 4 && (num_slots & (num_slots - 1)) == 0;
+
+	for (i = 0; valid && i < num_slots; i++) {
+		slots[i].id = -1;
+	}
+	in->slots = slots;
+	in->num_slots = valid ? num_slots : 0;
+	in->names = names;
+	in->names_size = names_size;
+	in->names_len = 0;
+	in->num_ids = 0;
+	in->ids = NULL;
+	return valid ? 0 : JSMN_ERROR_INVAL;
+}
+
+JSMN_API int jsmn_intern_key(jsmn_intern *in, const char *key,
+		unsigned int len) {
+	unsigned int hash = JSMN_FNV_BASIS;
+	unsigned int i;
+
+	for (i = 0; i < len; i++) {
+		hash = (hash ^ (unsigned char) key[i]) * JSMN_FNV_PRIME;
+	}
+	return jsmn_intern_insert(in, key, len, hash);
+}
+
+JSMN_API int jsmn_keyset_init(jsmn_keyset *set, const char *const *names,
+		unsigned int num_names) {
+	unsigned int i, j, k, len;
+	int cmp;
+
+	if (num_names > JSMN_KEYSET_MAX) {
+		return JSMN_ERROR_INVAL;
+	}
+	set->num_names = num_names;
+	set->lenmask = 0;
+	/* Insertion sort, sets are small and built once */
+	for (i = 0; i < num_names; i++) {
+		for (len = 0; names[i][len] != '\0'; len++);
+		set->lenmask |= 1UL << (len % 32);
+		for (j = i; j > 0; j--) {
+			cmp = 0;
+			if (len != set->lengths[j - 1]) {
+				cmp = len < set->lengths[j - 1] ? -1 : 1;
+			}
+			for (k = 0; cmp == 0 && k < len; k++) {
+				cmp = (unsigned char) names[i][k] -
+					(unsigned char) set->names[j - 1][k];
+			}
+			if (cmp == 0) {
+				return JSMN_ERROR_INVAL;
+			}
+			if (cmp > 0) {
+				break;
+			}
+			set->names[j] = set->names[j - 1];
+			set->lengths[j] = set->lengths[j - 1];
+		}
+		set->names[j] = names[i];
+		set->lengths[j] = len;
+	}
+	return 0;
+}
+
+JSMN_API void jsmn_get_error(const jsmn_parser *parser, const char *js,
+		jsmn_error *err) {
+	unsigned int i;
+
+	err->pos = parser->errpos;
+	err->line = 1;
+	err->col = 1;
+	for (i = 0; i < parser->errpos; i++) {
+		if (js[i] == '\n') {
+			err->line++;
+			err->col = 1;
+		} else {
+			err->col++;
+		}
+	}
+	err->token = (int) parser->toknext - 1;
+}
+
+JSMN_API int jsmn_recover(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens) {
+	unsigned int pos;
+	unsigned int i;
+
+	if (tokens != NULL) {
+		/* The outermost unclosed object or array starts the broken record */
+		for (i = 0; i < parser->toknext; i++) {
+			if (tokens[i].start != -1 && tokens[i].end == -1) {
+				parser->toknext = i;
+				break;
+			}
+		}
+	}
+	parser->toksuper = -1;
+
+	pos = parser->errpos;
+	while (pos < len && js[pos] != '\0' && js[pos] != '\n') {
+		pos++;
+	}
+	if (pos < len && js[pos] == '\n') {
+		pos++;
+	}
+	parser->pos = pos;
+	return parser->toknext;
+}
+
+/**
+ * Saves end and size of token i in snap, unless it is there already.
+ */
+static int jsmn_save_token(const jsmntok_t *tokens, int i,
+		jsmn_snapshot *snap) {
+	unsigned int k;
+
+	for (k = 0; k < snap->depth; k++) {
+		if (snap->index[k] == i) {
+			return 1;
+		}
+	}
+	if (snap->depth == JSMN_SNAPSHOT_DEPTH) {
+		return JSMN_ERROR_NOMEM;
+	}
+	snap->index[snap->depth] = i;
+	snap->end[snap->depth] = tokens[i].end;
+	snap->size[snap->depth] = tokens[i].size;
+	snap->depth++;
+	return 0;
+}
+
+JSMN_API int jsmn_save(const jsmn_parser *parser, const jsmntok_t *tokens,
+		jsmn_snapshot *snap) {
+	int i, r;
+
+	snap->parser = *parser;
+	snap->depth = 0;
+	if (tokens == NULL) {
+		return 0;
+	}
+	/*
+	 * Sizes change for the token the parser is in, the last token (a colon
+	 * makes it the parent of what follows) and tokens it goes back to on
+	 * commas and closing brackets: with parent links the ancestors of both,
+	 * otherwise the unclosed objects and arrays.
+	 */
+#ifdef JSMN_PARENT_LINKS
+	for (i = (int) parser->toknext - 1; i != -1; i = tokens[i].parent) {
+		if ((r = jsmn_save_token(tokens, i, snap)) < 0) {
+			return r;
+		}
+	}
+	for (i = parser->toksuper; i != -1; i = tokens[i].parent) {
+		if ((r = jsmn_save_token(tokens, i, snap)) != 0) {
+			return r < 0 ? r : 0;
+		}
+	}
+#else
+	for (i = (int) parser->toknext - 1; i >= 0; i--) {
+		if (i == (int) parser->toknext - 1 || i == parser->toksuper ||
+				(tokens[i].start != -1 && tokens[i].end == -1)) {
+			if ((r = jsmn_save_token(tokens, i, snap)) < 0) {
+				return r;
+			}
+		}
+	}
+#endif
+	return 0;
+}
+
+JSMN_API void jsmn_restore(jsmn_parser *parser, jsmntok_t *tokens,
+		const jsmn_snapshot *snap) {
+	unsigned int k;
+
+	*parser = snap->parser;
+	if (tokens == NULL) {
+		return;
+	}
+	for (k = 0; k < snap->depth; k++) {
+		tokens[snap->index[k]].end = snap->end[k];
+		tokens[snap->index[k]].size = snap->size[k];
+	}
+}
+
+#undef JSMN_TOK_TYPE
+#undef JSMN_TOK_START
+#undef JSMN_TOK_END
+#undef JSMN_TOK_SIZE
+#undef JSMN_TOK_PARENT
+#undef JSMN_LINKS
+#undef JSMN_LOOP_TEMPLATE
+#undef JSMN_LOOP
+#undef JSMN_LOOP_TOKEN
+#undef JSMN_LOOP_SOA
+#undef JSMN_LOOP_POS_MAX
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* JSMN_STATIC || JSMN_IMPLEMENTATION */
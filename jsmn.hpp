@@ -0,0 +1,392 @@
+#ifndef __JSMN_HPP_
+#define __JSMN_HPP_
+
+/*
+ * C++17 interface to jsmn. The parser is the C one: parser<Policy> is a
+ * jsmn_parser whose parse() expands jsmn_parse_impl() for the mode and the
+ * token type of the policy. Parser options are template policies rather than
+ * preprocessor switches, so strict and lenient, linked and unlinked, int and
+ * short token parsers can live in one binary, and each of them gets its own
+ * copy of the parsing loop with the options folded in at compile time.
+ *
+ * The loop is in the implementation part of jsmn.h, so it is included as
+ * JSMN_STATIC unless JSMN_IMPLEMENTATION is defined, and jsmn.hpp must come
+ * before anything else that includes that part.
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+#ifdef __JSMN_IMPL_H_
+#error "jsmn.hpp must be included before the jsmn.h implementation"
+#endif
+
+namespace jsmn {
+
+namespace detail {
+template <typename Token>
+using index_of = decltype(Token::start);
+
+template <typename Token, typename = void>
+struct has_parent : std::false_type {};
+
+template <typename Token>
+struct has_parent<Token, std::void_t<decltype(Token::parent)>>
+	: std::true_type {};
+
+/*
+ * Token arrays of the soa branch of the loop. C++ parsers never take that
+ * branch, it only has to compile for their index type.
+ */
+template <typename Index>
+struct soa {
+	unsigned char *type;
+	Index *start;
+	Index *end;
+	Index *size;
+	Index *parent;
+};
+
+/*
+ * Parent field of token i, for JSMN_TOK_PARENT(). Tokens without one only
+ * have it in soa.
+ */
+template <typename Token, typename Soa>
+inline auto *parent(Token *tokens, const Soa *soa, int i, int soa_mode) {
+	if constexpr (has_parent<Token>::value) {
+		return soa_mode ? &soa->parent[i] : &tokens[i].parent;
+	} else {
+		return &soa->parent[i];
+	}
+}
+
+/*
+ * Longest input the loop accepts for Token. As with JSMN_COMPACT, only
+ * fields narrower than int are checked.
+ */
+template <typename Token>
+constexpr std::size_t pos_max() {
+	if constexpr (sizeof(index_of<Token>) < sizeof(int)) {
+		return static_cast<std::size_t>(
+				std::numeric_limits<index_of<Token>>::max());
+	} else {
+		return std::numeric_limits<std::size_t>::max();
+	}
+}
+} /* namespace detail */
+
+} /* namespace jsmn */
+
+/* Parsing loop of jsmn.h as a template over the token type */
+#define JSMN_LOOP_TEMPLATE \
+	template <typename jsmn_loop_token, typename jsmn_loop_soa>
+#define JSMN_LOOP(f) f<jsmntok_t, jsmn_soa>
+#define JSMN_LOOP_TOKEN jsmn_loop_token
+#define JSMN_LOOP_SOA jsmn_loop_soa
+#define JSMN_LINKS (jsmn::detail::has_parent<jsmn_loop_token>::value)
+#define JSMN_TOK_PARENT(i) (*jsmn::detail::parent(tokens, soa, i, soa_mode))
+#define JSMN_LOOP_POS_MAX (jsmn::detail::pos_max<jsmn_loop_token>())
+
+#if !defined(JSMN_STATIC) && !defined(JSMN_IMPLEMENTATION)
+#define JSMN_STATIC
+#endif
+#include "jsmn.h"
+
+namespace jsmn {
+
+namespace detail {
+#ifdef JSMN_STRICT
+constexpr bool c_strict = true;
+#else
+constexpr bool c_strict = false;
+#endif
+#ifdef JSMN_PARENT_LINKS
+constexpr bool c_parent_links = true;
+#else
+constexpr bool c_parent_links = false;
+#endif
+} /* namespace detail */
+
+/**
+ * Token layout used by the default policies. Small index types also get a
+ * one byte type field, so policy<..., short> tokens take 8 or 10 bytes.
+ */
+template <typename Index, bool ParentLinks>
+struct basic_token {
+	std::conditional_t<(sizeof(Index) < sizeof(int)), unsigned char,
+		jsmntype_t> type;
+	Index start;
+	Index end;
+	Index size;
+};
+
+template <typename Index>
+struct basic_token<Index, true> {
+	std::conditional_t<(sizeof(Index) < sizeof(int)), unsigned char,
+		jsmntype_t> type;
+	Index start;
+	Index end;
+	Index size;
+	Index parent;
+};
+
+/**
+ * Parser policy.
+ * Strict	accept only valid JSON primitives (see jsmn_parser.strict)
+ * ParentLinks	keep parent index in tokens (JSMN_PARENT_LINKS)
+ * Index	integer type of token fields, also limits input length
+ * Token	token type, must have type/start/end/size (and parent) members
+ */
+template <bool Strict, bool ParentLinks, typename Index = int,
+		typename Token = basic_token<Index, ParentLinks>>
+struct policy {
+	static_assert(std::is_signed<Index>::value,
+			"token fields use -1 as 'unset' marker");
+	static_assert(detail::has_parent<Token>::value == ParentLinks,
+			"tokens have a parent member exactly with parent links");
+	static constexpr bool strict = Strict;
+	static constexpr bool parent_links = ParentLinks;
+	static constexpr std::size_t max_length =
+		static_cast<std::size_t>(std::numeric_limits<Index>::max());
+	using index_type = Index;
+	using token_type = Token;
+};
+
+using default_policy = policy<false, true>;
+using strict_policy = policy<true, true>;
+using compact_policy = policy<true, true, short>;
+
+/**
+ * Policy producing plain jsmntok_t tokens, matching the C configuration
+ * jsmn.h was included with.
+ */
+using c_policy = policy<detail::c_strict, detail::c_parent_links, jsmnint_t,
+		jsmntok_t>;
+
+/**
+ * JSON parser. A jsmn_parser with the options of Policy, so it has the same
+ * state and semantics as jsmn_parse(), including incremental parsing of
+ * partial input, token counting with tokens == nullptr, jsmn_parser.keys and
+ * jsmn_parser.intern, and it can be passed to the C functions taking a
+ * jsmn_parser (jsmn_get_error(), and with c_policy tokens jsmn_recover(),
+ * jsmn_save()...).
+ */
+template <typename Policy = default_policy>
+class parser : public jsmn_parser {
+public:
+	using policy_type = Policy;
+	using token_type = typename Policy::token_type;
+	using index_type = typename Policy::index_type;
+
+	parser() noexcept {
+		jsmn_init(this);
+		strict = Policy::strict;
+	}
+
+	/**
+	 * Starts over on a new document. Keys and intern stay set.
+	 */
+	void reset() noexcept {
+		pos = 0;
+		toknext = 0;
+		toksuper = -1;
+		errpos = 0;
+	}
+
+	template <std::size_t N>
+	int parse(std::string_view js, token_type (&tokens)[N]) noexcept {
+		return parse(js, tokens, static_cast<unsigned int>(N));
+	}
+
+	/**
+	 * Returns number of tokens needed to parse js.
+	 */
+	int count(std::string_view js) noexcept {
+		return parse(js, nullptr, 0);
+	}
+
+	int parse(std::string_view js, token_type *tokens,
+			unsigned int num_tokens) noexcept {
+		return jsmn_parse_impl<token_type,
+			detail::soa<detail::index_of<token_type>>>(this, js.data(),
+				js.size(), tokens, nullptr, num_tokens, Policy::strict, 0);
+	}
+};
+
+/**
+ * Returns pointer past the last token of the subtree rooted at t.
+ */
+template <typename Token>
+const Token *skip(const Token *t) noexcept {
+	long remaining = 1;
+	while (remaining > 0) {
+		remaining += t->size - 1;
+		t++;
+	}
+	return t;
+}
+
+/**
+ * Non-owning view of a parsed value: a token, the tokens following it and
+ * the source text. Copying it copies three pointers.
+ */
+template <typename Token>
+class value {
+public:
+	class iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = jsmn::value<Token>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = jsmn::value<Token>;
+
+		iterator() noexcept = default;
+		iterator(const char *js, const Token *tok, const Token *last,
+				int left) noexcept
+			: js_(js), tok_(tok), last_(last), left_(left) {}
+
+		reference operator*() const noexcept {
+			return jsmn::value<Token>(js_, tok_, last_);
+		}
+		iterator &operator++() noexcept {
+			tok_ = skip(tok_);
+			left_--;
+			return *this;
+		}
+		iterator operator++(int) noexcept {
+			iterator it = *this;
+			++*this;
+			return it;
+		}
+		bool operator==(const iterator &other) const noexcept {
+			return left_ == other.left_;
+		}
+		bool operator!=(const iterator &other) const noexcept {
+			return left_ != other.left_;
+		}
+
+	private:
+		const char *js_ = nullptr;
+		const Token *tok_ = nullptr;
+		const Token *last_ = nullptr;
+		int left_ = 0;
+	};
+
+	value() noexcept = default;
+	value(const char *js, const Token *tok, const Token *last) noexcept
+		: js_(js), tok_(tok), last_(last) {}
+
+	bool valid() const noexcept { return tok_ != nullptr; }
+	explicit operator bool() const noexcept { return valid(); }
+	const Token *token() const noexcept { return tok_; }
+
+	jsmntype_t type() const noexcept {
+		return tok_ ? static_cast<jsmntype_t>(tok_->type) : JSMN_UNDEFINED;
+	}
+	bool is_object() const noexcept { return type() == JSMN_OBJECT; }
+	bool is_array() const noexcept { return type() == JSMN_ARRAY; }
+	bool is_string() const noexcept { return type() == JSMN_STRING; }
+	bool is_primitive() const noexcept { return type() == JSMN_PRIMITIVE; }
+
+	/**
+	 * Number of children: members of an object, elements of an array, 1 for
+	 * an object key.
+	 */
+	int size() const noexcept { return tok_ ? tok_->size : 0; }
+
+	/**
+	 * Raw text of the value. Strings are returned without quotes and with
+	 * escapes untouched.
+	 */
+	std::string_view str() const noexcept {
+		if (tok_ == nullptr) {
+			return std::string_view();
+		}
+		return std::string_view(js_ + tok_->start, tok_->end - tok_->start);
+	}
+
+	iterator begin() const noexcept {
+		return iterator(js_, tok_ + 1, last_, size());
+	}
+	iterator end() const noexcept {
+		return iterator(js_, nullptr, last_, 0);
+	}
+
+	/**
+	 * First child: the value of an object key, the first array element etc.
+	 */
+	value front() const noexcept {
+		if (size() == 0 || tok_ + 1 >= last_) {
+			return value();
+		}
+		return value(js_, tok_ + 1, last_);
+	}
+
+	/**
+	 * Looks up a member of an object by its key.
+	 */
+	value operator[](std::string_view key) const noexcept {
+		if (!is_object()) {
+			return value();
+		}
+		for (value k : *this) {
+			if (k.str() == key) {
+				return k.front();
+			}
+		}
+		return value();
+	}
+
+	/**
+	 * Returns n-th array element.
+	 */
+	value operator[](std::size_t n) const noexcept {
+		iterator it = begin();
+		if (!is_array() || n >= static_cast<std::size_t>(size())) {
+			return value();
+		}
+		for (; n > 0; n--) {
+			++it;
+		}
+		return *it;
+	}
+
+private:
+	const char *js_ = nullptr;
+	const Token *tok_ = nullptr;
+	const Token *last_ = nullptr;
+};
+
+/**
+ * Non-owning view of a parsed document.
+ */
+template <typename Token>
+class document {
+public:
+	document(std::string_view js, const Token *tokens, std::size_t count) noexcept
+		: js_(js), tokens_(tokens), count_(count) {}
+
+	std::string_view source() const noexcept { return js_; }
+	std::size_t size() const noexcept { return count_; }
+	const Token *tokens() const noexcept { return tokens_; }
+
+	value<Token> root() const noexcept {
+		if (count_ == 0) {
+			return value<Token>();
+		}
+		return value<Token>(js_.data(), tokens_, tokens_ + count_);
+	}
+
+private:
+	std::string_view js_;
+	const Token *tokens_;
+	std::size_t count_;
+};
+
+} /* namespace jsmn */
+
+#endif /* __JSMN_HPP_ */
@@ -0,0 +1,365 @@
+#include <limits.h>
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsmn_bind.h"
+
+int jsmn_schema_init(jsmn_schema *schema, const jsmn_field *fields,
+		unsigned int num_fields) {
+	const char *names[JSMN_SCHEMA_MAX] = { NULL };
+	unsigned int i, k;
+
+	if (num_fields > JSMN_SCHEMA_MAX) {
+		return JSMN_ERROR_NOMEM;
+	}
+	schema->fields = fields;
+	schema->num_fields = num_fields;
+	for (i = 0; i < num_fields; i++) {
+		names[i] = fields[i].name;
+	}
+	if (jsmn_keyset_init(&schema->names, names, num_fields) < 0) {
+		return JSMN_ERROR_INVAL;
+	}
+	/* Names are distinct strings, so their pointers tell the fields apart */
+	for (k = 0; k < num_fields; k++) {
+		for (i = 0; fields[i].name != schema->names.names[k]; i++);
+		schema->order[k] = (unsigned char) i;
+	}
+	return 0;
+}
+
+int jsmn_schema_find(const jsmn_schema *schema, const char *key, size_t len) {
+	int k;
+
+	if ((unsigned int) len != len) {
+		return -1;
+	}
+	k = jsmn_keyset_find(&schema->names, key, (unsigned int) len);
+	return k < 0 ? -1 : schema->order[k];
+}
+
+/**
+ * Returns index of the token after the value at tokens[i].
+ */
+static int jsmn_bind_skip(const jsmntok_t *tokens, int num_tokens, int i) {
+	int end = tokens[i].end;
+
+	for (i++; i < num_tokens && tokens[i].start < end; i++);
+	return i;
+}
+
+static size_t jsmn_bind_digits(const char *s, size_t len, size_t i) {
+	while (i < len && s[i] >= '0' && s[i] <= '9') {
+		i++;
+	}
+	return i;
+}
+
+int jsmn_scan_number(const char *s, size_t len, size_t *end, int *integer) {
+	size_t i = 0;
+
+	*integer = 1;
+	if (i < len && s[i] == '-') {
+		i++;
+	}
+	if (i == len || s[i] < '0' || s[i] > '9') {
+		goto fail;
+	}
+	/* No leading zeros */
+	if (s[i++] != '0') {
+		i = jsmn_bind_digits(s, len, i);
+	}
+	if (i < len && s[i] == '.') {
+		*integer = 0;
+		i++;
+		if (jsmn_bind_digits(s, len, i) == i) {
+			goto fail;
+		}
+		i = jsmn_bind_digits(s, len, i);
+	}
+	if (i < len && (s[i] == 'e' || s[i] == 'E')) {
+		*integer = 0;
+		i++;
+		if (i < len && (s[i] == '+' || s[i] == '-')) {
+			i++;
+		}
+		if (jsmn_bind_digits(s, len, i) == i) {
+			goto fail;
+		}
+		i = jsmn_bind_digits(s, len, i);
+	}
+	*end = i;
+	return 0;
+
+fail:
+	*end = i;
+	return i == len ? JSMN_ERROR_PART : JSMN_ERROR_INVAL;
+}
+
+static int jsmn_bind_integer(const char *s, size_t len, long long min,
+		long long max, long long *v) {
+	unsigned long long n = 0;
+	unsigned long long limit;
+	size_t i, end;
+	int integer;
+
+	if (jsmn_scan_number(s, len, &end, &integer) < 0 || end != len ||
+			!integer) {
+		return JSMN_ERROR_INVAL;
+	}
+	i = s[0] == '-';
+	limit = i ? (unsigned long long) -(min + 1) + 1 : (unsigned long long) max;
+	for (; i < len; i++) {
+		unsigned int d = (unsigned int) (s[i] - '0');
+		if (n > (limit - d) / 10) {
+			return JSMN_ERROR_INVAL;
+		}
+		n = n * 10 + d;
+	}
+	*v = s[0] == '-' ? (long long) (0 - n) : (long long) n;
+	return 0;
+}
+
+/**
+ * Converts len bytes of s holding a JSON number. strtod() also takes hex,
+ * inf, nan and leading spaces, so the grammar is checked first, and it reads
+ * the decimal point of the LC_NUMERIC locale, so the '.' is replaced by it.
+ */
+static int jsmn_bind_double(const char *s, size_t len, double *v) {
+	const char *point = localeconv()->decimal_point;
+	size_t plen = strlen(point);
+	const char *dot;
+	size_t n;
+	int integer;
+	char buf[72];
+	char *end;
+
+	if (jsmn_scan_number(s, len, &n, &integer) < 0 || n != len ||
+			len >= 64 || plen == 0 || plen > 8) {
+		return JSMN_ERROR_INVAL;
+	}
+	dot = (const char *) memchr(s, '.', len);
+	n = dot != NULL ? (size_t) (dot - s) : len;
+	memcpy(buf, s, n);
+	if (dot != NULL) {
+		memcpy(buf + n, point, plen);
+		memcpy(buf + n + plen, dot + 1, len - n - 1);
+		n = len - 1 + plen;
+	}
+	buf[n] = '\0';
+	*v = strtod(buf, &end);
+	if (end != buf + n) {
+		return JSMN_ERROR_INVAL;
+	}
+	return 0;
+}
+
+static long jsmn_bind_hex4(const char *s) {
+	long v = 0;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		char c = s[i];
+		v <<= 4;
+		if (c >= '0' && c <= '9') {
+			v |= c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			v |= c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			v |= c - 'A' + 10;
+		} else {
+			return -1;
+		}
+	}
+	return v;
+}
+
+int jsmn_unescape(const char *s, size_t len, char *out, size_t size) {
+	size_t i, n = 0;
+
+	for (i = 0; i < len; i++) {
+		char c = s[i];
+		if (c == '\\' && i + 1 < len) {
+			long cp, lo;
+			char utf8[4];
+			size_t k, m;
+
+			switch (s[++i]) {
+				case 'b': c = '\b'; break;
+				case 'f': c = '\f'; break;
+				case 'n': c = '\n'; break;
+				case 'r': c = '\r'; break;
+				case 't': c = '\t'; break;
+				case 'u':
+					if (i + 4 >= len || (cp = jsmn_bind_hex4(s + i + 1)) < 0) {
+						return JSMN_ERROR_INVAL;
+					}
+					i += 4;
+					/* Surrogate pair */
+					if (cp >= 0xd800 && cp < 0xdc00 && i + 6 < len &&
+							s[i + 1] == '\\' && s[i + 2] == 'u' &&
+							(lo = jsmn_bind_hex4(s + i + 3)) >= 0xdc00 &&
+							lo < 0xe000) {
+						cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+						i += 6;
+					}
+					if (cp < 0x80) {
+						utf8[0] = (char) cp;
+						m = 1;
+					} else if (cp < 0x800) {
+						utf8[0] = (char) (0xc0 | (cp >> 6));
+						utf8[1] = (char) (0x80 | (cp & 0x3f));
+						m = 2;
+					} else if (cp < 0x10000) {
+						utf8[0] = (char) (0xe0 | (cp >> 12));
+						utf8[1] = (char) (0x80 | ((cp >> 6) & 0x3f));
+						utf8[2] = (char) (0x80 | (cp & 0x3f));
+						m = 3;
+					} else {
+						utf8[0] = (char) (0xf0 | (cp >> 18));
+						utf8[1] = (char) (0x80 | ((cp >> 12) & 0x3f));
+						utf8[2] = (char) (0x80 | ((cp >> 6) & 0x3f));
+						utf8[3] = (char) (0x80 | (cp & 0x3f));
+						m = 4;
+					}
+					if (n + m >= size) {
+						return JSMN_ERROR_NOMEM;
+					}
+					for (k = 0; k < m; k++) {
+						out[n++] = utf8[k];
+					}
+					continue;
+				default:
+					/* \" \\ and \/ stand for themselves */
+					c = s[i];
+					break;
+			}
+		}
+		if (n + 1 >= size) {
+			return JSMN_ERROR_NOMEM;
+		}
+		out[n++] = c;
+	}
+	if (size == 0) {
+		return JSMN_ERROR_NOMEM;
+	}
+	out[n] = '\0';
+	return (int) n;
+}
+
+static int jsmn_bind_object(const char *js, const jsmntok_t *tokens,
+		int num_tokens, int i, const jsmn_schema *schema, char *out,
+		int *bound);
+
+/**
+ * Stores the value at tokens[i] to out. Returns index of the next token.
+ */
+static int jsmn_bind_value(const char *js, const jsmntok_t *tokens,
+		int num_tokens, int i, const jsmn_field *field, char *out,
+		int *bound) {
+	const jsmntok_t *t = &tokens[i];
+	const char *s = js + t->start;
+	size_t len = (size_t) (t->end - t->start);
+	long long v;
+	double d;
+	int r;
+
+	if (field->type == JSMN_BIND_OBJECT) {
+		return jsmn_bind_object(js, tokens, num_tokens, i, field->schema, out,
+				bound);
+	}
+	if (t->type != (field->type == JSMN_BIND_STRING ?
+				JSMN_STRING : JSMN_PRIMITIVE)) {
+		return JSMN_ERROR_INVAL;
+	}
+	switch (field->type) {
+		case JSMN_BIND_INT:
+			r = jsmn_bind_integer(s, len, INT_MIN, INT_MAX, &v);
+			if (r == 0) {
+				*(int *) out = (int) v;
+			}
+			break;
+		case JSMN_BIND_LONG:
+			r = jsmn_bind_integer(s, len, LLONG_MIN, LLONG_MAX, &v);
+			if (r == 0) {
+				*(long long *) out = v;
+			}
+			break;
+		case JSMN_BIND_DOUBLE:
+			r = jsmn_bind_double(s, len, &d);
+			if (r == 0) {
+				*(double *) out = d;
+			}
+			break;
+		case JSMN_BIND_BOOL:
+			r = 0;
+			if (len == 4 && memcmp(s, "true", 4) == 0) {
+				*(int *) out = 1;
+			} else if (len == 5 && memcmp(s, "false", 5) == 0) {
+				*(int *) out = 0;
+			} else {
+				r = JSMN_ERROR_INVAL;
+			}
+			break;
+		case JSMN_BIND_STRING:
+			r = jsmn_unescape(s, len, out, field->size);
+			break;
+		default:
+			r = JSMN_ERROR_INVAL;
+			break;
+	}
+	if (r < 0) {
+		return r;
+	}
+	(*bound)++;
+	return i + 1;
+}
+
+static int jsmn_bind_object(const char *js, const jsmntok_t *tokens,
+		int num_tokens, int i, const jsmn_schema *schema, char *out,
+		int *bound) {
+	int members, n, f;
+
+	if (tokens[i].type != JSMN_OBJECT) {
+		return JSMN_ERROR_INVAL;
+	}
+	members = tokens[i].size;
+	i++;
+	for (n = 0; n < members; n++) {
+		const jsmntok_t *key = &tokens[i];
+		const jsmntok_t *value = &tokens[i + 1];
+
+		if (i + 1 >= num_tokens || key->size != 1) {
+			return JSMN_ERROR_INVAL;
+		}
+		f = jsmn_schema_find(schema, js + key->start,
+				(size_t) (key->end - key->start));
+		i++;
+		if (f < 0 || (value->type == JSMN_PRIMITIVE &&
+					value->end - value->start == 4 &&
+					memcmp(js + value->start, "null", 4) == 0)) {
+			i = jsmn_bind_skip(tokens, num_tokens, i);
+			continue;
+		}
+		i = jsmn_bind_value(js, tokens, num_tokens, i, &schema->fields[f],
+				out + schema->fields[f].offset, bound);
+		if (i < 0) {
+			return i;
+		}
+	}
+	return i;
+}
+
+int jsmn_bind(const char *js, const jsmntok_t *tokens, int num_tokens,
+		const jsmn_schema *schema, void *out) {
+	int bound = 0;
+	int r;
+
+	if (num_tokens < 1) {
+		return JSMN_ERROR_INVAL;
+	}
+	r = jsmn_bind_object(js, tokens, num_tokens, 0, schema, (char *) out,
+			&bound);
+	return r < 0 ? r : bound;
+}
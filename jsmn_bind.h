@@ -0,0 +1,113 @@
+#ifndef __JSMN_BIND_H_
+#define __JSMN_BIND_H_
+
+#include <stddef.h>
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * C types a JSON value can be stored to:
+ * 	o JSMN_BIND_INT - int, from an integer number
+ * 	o JSMN_BIND_LONG - long long, from an integer number
+ * 	o JSMN_BIND_DOUBLE - double, from any JSON number (in any locale)
+ * 	o JSMN_BIND_BOOL - int set to 0 or 1, from false or true
+ * 	o JSMN_BIND_STRING - char array of the field size, from a string, which
+ * 	  is unescaped and terminated with '\0'
+ * 	o JSMN_BIND_OBJECT - nested struct described by another schema, from an
+ * 	  object
+ */
+typedef enum {
+	JSMN_BIND_INT = 1,
+	JSMN_BIND_LONG = 2,
+	JSMN_BIND_DOUBLE = 3,
+	JSMN_BIND_BOOL = 4,
+	JSMN_BIND_STRING = 5,
+	JSMN_BIND_OBJECT = 6
+} jsmn_bind_type;
+
+struct jsmn_schema;
+
+/**
+ * Member of a struct bound to a JSON object member.
+ * name		object member name (as it appears in JSON, without escapes)
+ * type		type of the struct member
+ * offset	offsetof() the struct member
+ * size		sizeof() the struct member, used by JSMN_BIND_STRING
+ * schema	fields of the nested struct for JSMN_BIND_OBJECT
+ */
+typedef struct {
+	const char *name;
+	jsmn_bind_type type;
+	size_t offset;
+	size_t size;
+	const struct jsmn_schema *schema;
+} jsmn_field;
+
+#define JSMN_FIELD(st, member, name, type) \
+	{ name, type, offsetof(st, member), sizeof(((st *) 0)->member), NULL }
+#define JSMN_FIELD_OBJECT(st, member, name, schema) \
+	{ name, JSMN_BIND_OBJECT, offsetof(st, member), \
+		sizeof(((st *) 0)->member), schema }
+
+#define JSMN_SCHEMA_MAX JSMN_KEYSET_MAX
+
+/**
+ * Schema of a struct: its fields and a jsmn_keyset of their names, so keys
+ * are looked up like those of jsmn_parser.keys. order maps the position of a
+ * name in names to its field. Fill it once with jsmn_schema_init(), it is
+ * read-only afterwards.
+ */
+typedef struct jsmn_schema {
+	const jsmn_field *fields;
+	unsigned int num_fields;
+	jsmn_keyset names;
+	unsigned char order[JSMN_SCHEMA_MAX];
+} jsmn_schema;
+
+/**
+ * Prepares schema for fields. Returns JSMN_ERROR_NOMEM for more than
+ * JSMN_SCHEMA_MAX fields and JSMN_ERROR_INVAL for duplicate names.
+ */
+int jsmn_schema_init(jsmn_schema *schema, const jsmn_field *fields,
+		unsigned int num_fields);
+
+/**
+ * Returns index of the field named by len bytes of key, or -1.
+ */
+int jsmn_schema_find(const jsmn_schema *schema, const char *key, size_t len);
+
+/**
+ * Decodes the object at tokens[0] into out, walking the tokens once. Members
+ * without a field and null values are skipped, struct members of fields not
+ * present in the object keep their values. Returns the number of fields
+ * stored (including nested ones), JSMN_ERROR_INVAL if a value does not match
+ * its field type, or JSMN_ERROR_NOMEM if a string does not fit.
+ */
+int jsmn_bind(const char *js, const jsmntok_t *tokens, int num_tokens,
+		const jsmn_schema *schema, void *out);
+
+/**
+ * Checks the JSON number at the start of len bytes of s and sets *end past
+ * it, or to where it goes wrong. Sets *integer if it has neither fraction
+ * nor exponent. Returns 0, JSMN_ERROR_INVAL, or JSMN_ERROR_PART if s ends
+ * inside the number. jsmn_bind() and the column loader read numbers by it.
+ */
+int jsmn_scan_number(const char *s, size_t len, size_t *end, int *integer);
+
+/**
+ * Copies len bytes of JSON string contents to out, decoding escapes (\u as
+ * UTF-8) and terminating it with '\0'. The result is never longer than the
+ * input. Returns its length, JSMN_ERROR_INVAL for a bad \u escape or
+ * JSMN_ERROR_NOMEM if it does not fit into size bytes.
+ */
+int jsmn_unescape(const char *s, size_t len, char *out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_BIND_H_ */
@@ -0,0 +1,531 @@
+#include <string.h>
+
+#include "jsmn_canon.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JSMN_CANON_SSE2
+#endif
+
+#define JSMN_CANON_SPACE(c) \
+	((c) == ' ' || (c) == '\n' || (c) == '\r' || (c) == '\t')
+
+/**
+ * Returns index of the first token after the subtree of token i.
+ */
+static int jsmn_canon_skip(const jsmntok_t *tokens, int num_tokens, int i) {
+	int remaining = 1;
+	while (remaining > 0 && i < num_tokens) {
+		remaining += tokens[i].size - 1;
+		i++;
+	}
+	return i;
+}
+
+/**
+ * Appends len bytes of s without whitespace.
+ */
+static void jsmn_minify_span(jsmn_writer *w, const char *s, size_t len) {
+	size_t i = 0;
+	size_t run;
+
+	if (w->len <= w->size && len <= w->size - w->len) {
+		/* Fits: stores past the last kept byte stay within s's length */
+		char *out = w->buf + w->len;
+		size_t n = 0;
+#ifdef JSMN_CANON_SSE2
+		const __m128i sp = _mm_set1_epi8(' ');
+		const __m128i nl = _mm_set1_epi8('\n');
+		const __m128i cr = _mm_set1_epi8('\r');
+		const __m128i tab = _mm_set1_epi8('\t');
+
+		for (; i + 16 <= len; i += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i *) (s + i));
+			__m128i ws = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, nl)),
+					_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, tab)));
+			unsigned int keep = ~(unsigned int) _mm_movemask_epi8(ws) & 0xffff;
+			unsigned int k;
+
+			if (keep == 0xffff) {
+				_mm_storeu_si128((__m128i *) (out + n), v);
+				n += 16;
+			} else if (keep != 0) {
+				for (k = 0; k < 16; k++) {
+					out[n] = s[i + k];
+					n += (keep >> k) & 1;
+				}
+			}
+		}
+#endif
+		for (; i < len; i++) {
+			out[n] = s[i];
+			n += !JSMN_CANON_SPACE(s[i]);
+		}
+		w->len += n;
+		return;
+	}
+	while (i < len) {
+		for (run = i; i < len && !JSMN_CANON_SPACE(s[i]); i++);
+		jsmn_write_raw(w, s + run, i - run);
+		for (; i < len && JSMN_CANON_SPACE(s[i]); i++);
+	}
+}
+
+int jsmn_minify(jsmn_writer *w, const char *js, const jsmntok_t *tokens,
+		int num_tokens) {
+	size_t pos;
+	int end, i;
+
+	if (num_tokens <= 0) {
+		return JSMN_ERROR_INVAL;
+	}
+	end = jsmn_canon_skip(tokens, num_tokens, 0);
+	pos = tokens[0].type == JSMN_STRING ? tokens[0].start - 1 : tokens[0].start;
+	for (i = 0; i < end; i++) {
+		if (tokens[i].type == JSMN_STRING) {
+			/* Strings with their quotes as they are */
+			jsmn_minify_span(w, js + pos, tokens[i].start - 1 - pos);
+			jsmn_write_raw(w, js + tokens[i].start - 1,
+					tokens[i].end - tokens[i].start + 2);
+			pos = tokens[i].end + 1;
+		}
+	}
+	if (tokens[0].type != JSMN_STRING) {
+		jsmn_minify_span(w, js + pos, tokens[0].end - pos);
+	}
+	return (int) w->len;
+}
+
+static long jsmn_canon_hex4(const char *s) {
+	long v = 0;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		char c = s[i];
+		v <<= 4;
+		if (c >= '0' && c <= '9') {
+			v |= c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			v |= c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			v |= c - 'A' + 10;
+		} else {
+			return -1;
+		}
+	}
+	return v;
+}
+
+/**
+ * Writes the canonical form of the character at s[*i] of string contents to
+ * out (at most 6 bytes) and moves *i past it. Returns the number of bytes.
+ */
+static size_t jsmn_canon_char(const char *s, size_t len, size_t *i,
+		char *out) {
+	static const char hex[] = "0123456789abcdef";
+	unsigned char c = (unsigned char) s[(*i)++];
+	long cp, lo;
+
+	if (c == '\\' && *i < len) {
+		c = (unsigned char) s[(*i)++];
+		switch (c) {
+			case 'b': c = '\b'; break;
+			case 'f': c = '\f'; break;
+			case 'n': c = '\n'; break;
+			case 'r': c = '\r'; break;
+			case 't': c = '\t'; break;
+			case 'u':
+				if (*i + 4 > len || (cp = jsmn_canon_hex4(s + *i)) < 0) {
+					break;
+				}
+				*i += 4;
+				if (cp >= 0xd800 && cp < 0xdc00 && *i + 6 <= len &&
+						s[*i] == '\\' && s[*i + 1] == 'u' &&
+						(lo = jsmn_canon_hex4(s + *i + 2)) >= 0xdc00 &&
+						lo < 0xe000) {
+					cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+					*i += 6;
+				}
+				if (cp < 0x80) {
+					c = (unsigned char) cp;
+					break;
+				}
+				if (cp < 0x800) {
+					out[0] = (char) (0xc0 | (cp >> 6));
+					out[1] = (char) (0x80 | (cp & 0x3f));
+					return 2;
+				}
+				if (cp >= 0xd800 && cp < 0xe000) {
+					/* Lone surrogates have no UTF-8 form */
+					out[0] = '\\';
+					out[1] = 'u';
+					out[2] = hex[(cp >> 12) & 15];
+					out[3] = hex[(cp >> 8) & 15];
+					out[4] = hex[(cp >> 4) & 15];
+					out[5] = hex[cp & 15];
+					return 6;
+				}
+				if (cp < 0x10000) {
+					out[0] = (char) (0xe0 | (cp >> 12));
+					out[1] = (char) (0x80 | ((cp >> 6) & 0x3f));
+					out[2] = (char) (0x80 | (cp & 0x3f));
+					return 3;
+				}
+				out[0] = (char) (0xf0 | (cp >> 18));
+				out[1] = (char) (0x80 | ((cp >> 12) & 0x3f));
+				out[2] = (char) (0x80 | ((cp >> 6) & 0x3f));
+				out[3] = (char) (0x80 | (cp & 0x3f));
+				return 4;
+			default:
+				/* \" \\ and \/ stand for themselves */
+				break;
+		}
+	}
+	if (c >= 32 && c != '\"' && c != '\\') {
+		out[0] = (char) c;
+		return 1;
+	}
+	out[0] = '\\';
+	switch (c) {
+		case '\"': out[1] = '\"'; return 2;
+		case '\\': out[1] = '\\'; return 2;
+		case '\b': out[1] = 'b'; return 2;
+		case '\f': out[1] = 'f'; return 2;
+		case '\n': out[1] = 'n'; return 2;
+		case '\r': out[1] = 'r'; return 2;
+		case '\t': out[1] = 't'; return 2;
+		default:
+			out[1] = 'u';
+			out[2] = '0';
+			out[3] = '0';
+			out[4] = hex[c >> 4];
+			out[5] = hex[c & 15];
+			return 6;
+	}
+}
+
+static void jsmn_canon_string(jsmn_writer *w, const char *s, size_t len) {
+	char out[6];
+	size_t run;
+	size_t i = 0;
+
+	jsmn_write_raw(w, "\"", 1);
+	while (i < len) {
+		for (run = i; i < len && (unsigned char) s[i] >= 32 && s[i] != '\\' &&
+				s[i] != '\"'; i++);
+		jsmn_write_raw(w, s + run, i - run);
+		if (i < len) {
+			jsmn_write_raw(w, out, jsmn_canon_char(s, len, &i, out));
+		}
+	}
+	jsmn_write_raw(w, "\"", 1);
+}
+
+/**
+ * Compares the canonical forms of two keys, then their token indexes.
+ */
+static int jsmn_canon_keycmp(const char *js, const jsmntok_t *tokens, int a,
+		int b) {
+	const char *sa = js + tokens[a].start;
+	const char *sb = js + tokens[b].start;
+	size_t alen = tokens[a].end - tokens[a].start;
+	size_t blen = tokens[b].end - tokens[b].start;
+	size_t i = 0, j = 0;
+	int cmp;
+
+	if (memchr(sa, '\\', alen) == NULL && memchr(sb, '\\', blen) == NULL) {
+		cmp = memcmp(sa, sb, alen < blen ? alen : blen);
+		if (cmp == 0 && alen != blen) {
+			cmp = alen < blen ? -1 : 1;
+		}
+	} else {
+		char ca[6], cb[6];
+		size_t na = 0, nb = 0, ka = 0, kb = 0;
+
+		for (cmp = 0; cmp == 0; ka++, kb++) {
+			if (ka == na) {
+				if (i == alen) {
+					cmp = j == blen && kb == nb ? 0 : -1;
+					break;
+				}
+				na = jsmn_canon_char(sa, alen, &i, ca);
+				ka = 0;
+			}
+			if (kb == nb) {
+				if (j == blen) {
+					cmp = 1;
+					break;
+				}
+				nb = jsmn_canon_char(sb, blen, &j, cb);
+				kb = 0;
+			}
+			cmp = (int) (unsigned char) ca[ka] - (int) (unsigned char) cb[kb];
+		}
+	}
+	return cmp != 0 ? cmp : a - b;
+}
+
+/**
+ * Heap sort of member keys, the index tie break makes it stable.
+ */
+static void jsmn_canon_sort(const char *js, const jsmntok_t *tokens,
+		int *keys, int n) {
+	int start, end, root, child, t;
+
+	for (start = n / 2 - 1, end = n; end > 1;) {
+		if (start >= 0) {
+			root = start--;
+		} else {
+			end--;
+			t = keys[0];
+			keys[0] = keys[end];
+			keys[end] = t;
+			root = 0;
+		}
+		while ((child = 2 * root + 1) < end) {
+			if (child + 1 < end && jsmn_canon_keycmp(js, tokens, keys[child],
+						keys[child + 1]) < 0) {
+				child++;
+			}
+			if (jsmn_canon_keycmp(js, tokens, keys[root], keys[child]) >= 0) {
+				break;
+			}
+			t = keys[root];
+			keys[root] = keys[child];
+			keys[child] = t;
+			root = child;
+		}
+	}
+}
+
+/**
+ * Writes the significant digits [from, to) of a number whose first
+ * significant digit is at s[first], skipping the decimal point at s[dot].
+ */
+static void jsmn_canon_digits(jsmn_writer *w, const char *s, size_t first,
+		size_t dot, long from, long to) {
+	size_t a = first + from;
+	size_t b = first + to;
+
+	if (first < dot && a >= dot) {
+		a++;
+	}
+	if (first < dot && b > dot) {
+		b++;
+	}
+	if (a < dot && b > dot) {
+		jsmn_write_raw(w, s + a, dot - a);
+		a = dot + 1;
+	}
+	jsmn_write_raw(w, s + a, b - a);
+}
+
+static void jsmn_canon_zeros(jsmn_writer *w, long n) {
+	static const char zeros[] = "0000000000000000";
+	for (; n > 16; n -= 16) {
+		jsmn_write_raw(w, zeros, 16);
+	}
+	jsmn_write_raw(w, zeros, (size_t) n);
+}
+
+/**
+ * Writes the number in len bytes of s as sign, significant digits and the
+ * position of the decimal point, all exact.
+ */
+static int jsmn_canon_number(jsmn_writer *w, const char *s, size_t len) {
+	size_t i = 0;
+	size_t start; /* first digit */
+	size_t dot = len; /* position of '.', len if none */
+	size_t first = len, last = len; /* first and last nonzero digit */
+	long digits; /* significant digits, from first to last */
+	long point; /* significant digits before the decimal point */
+	long exp = 0;
+	int neg = 0;
+	char buf[24];
+	size_t n;
+
+	if (i < len && s[i] == '-') {
+		neg = 1;
+		i++;
+	}
+	if (i == len || s[i] < '0' || s[i] > '9' ||
+			(s[i] == '0' && i + 1 < len && s[i + 1] >= '0' && s[i + 1] <= '9')) {
+		return JSMN_ERROR_INVAL;
+	}
+	for (start = i; i < len && s[i] >= '0' && s[i] <= '9'; i++) {
+		if (s[i] != '0') {
+			first = first == len ? i : first;
+			last = i;
+		}
+	}
+	point = (long) (i - start);
+	if (i < len && s[i] == '.') {
+		dot = i++;
+		if (i == len || s[i] < '0' || s[i] > '9') {
+			return JSMN_ERROR_INVAL;
+		}
+		for (; i < len && s[i] >= '0' && s[i] <= '9'; i++) {
+			if (s[i] != '0') {
+				first = first == len ? i : first;
+				last = i;
+			}
+		}
+	}
+	if (i < len && (s[i] == 'e' || s[i] == 'E')) {
+		int eneg = 0;
+		i++;
+		if (i < len && (s[i] == '+' || s[i] == '-')) {
+			eneg = s[i++] == '-';
+		}
+		if (i == len || s[i] < '0' || s[i] > '9') {
+			return JSMN_ERROR_INVAL;
+		}
+		for (; i < len && s[i] >= '0' && s[i] <= '9'; i++) {
+			if (exp < 1000000000L) {
+				exp = exp * 10 + (s[i] - '0');
+			}
+		}
+		exp = eneg ? -exp : exp;
+	}
+	if (i != len) {
+		return JSMN_ERROR_INVAL;
+	}
+	if (first == len) {
+		jsmn_write_raw(w, "0", 1);
+		return 0;
+	}
+
+	/* Value is 0.ddd times 10 to the point, ddd the significant digits */
+	digits = (long) (last - first) + 1 - (first < dot && last > dot);
+	point -= (long) (first - start) - (first > dot);
+	point += exp;
+
+	if (neg) {
+		jsmn_write_raw(w, "-", 1);
+	}
+	if (digits <= point && point <= 21) {
+		jsmn_canon_digits(w, s, first, dot, 0, digits);
+		jsmn_canon_zeros(w, point - digits);
+	} else if (0 < point && point <= 21) {
+		jsmn_canon_digits(w, s, first, dot, 0, point);
+		jsmn_write_raw(w, ".", 1);
+		jsmn_canon_digits(w, s, first, dot, point, digits);
+	} else if (-6 < point && point <= 0) {
+		jsmn_write_raw(w, "0.", 2);
+		jsmn_canon_zeros(w, -point);
+		jsmn_canon_digits(w, s, first, dot, 0, digits);
+	} else {
+		jsmn_canon_digits(w, s, first, dot, 0, 1);
+		if (digits > 1) {
+			jsmn_write_raw(w, ".", 1);
+			jsmn_canon_digits(w, s, first, dot, 1, digits);
+		}
+		point--;
+		buf[0] = 'e';
+		buf[1] = point < 0 ? '-' : '+';
+		n = sizeof(buf);
+		point = point < 0 ? -point : point;
+		do {
+			buf[--n] = (char) ('0' + point % 10);
+			point /= 10;
+		} while (point > 0);
+		jsmn_write_raw(w, buf, 2);
+		jsmn_write_raw(w, buf + n, sizeof(buf) - n);
+	}
+	return 0;
+}
+
+struct jsmn_canon {
+	jsmn_writer *w;
+	const char *js;
+	const jsmntok_t *tokens;
+	int num_tokens;
+};
+
+/**
+ * Writes token i, returns index of the token after its subtree.
+ */
+static int jsmn_canon_value(struct jsmn_canon *c, int i, int *scratch) {
+	const jsmntok_t *t = &c->tokens[i];
+	const char *s = c->js + t->start;
+	size_t len = t->end - t->start;
+	int n = t->size;
+	int j = i + 1;
+	int k;
+
+	switch (t->type) {
+		case JSMN_OBJECT:
+			for (k = 0; k < n; k++) {
+				if (j >= c->num_tokens || c->tokens[j].type != JSMN_STRING ||
+						c->tokens[j].size != 1) {
+					return JSMN_ERROR_INVAL;
+				}
+				scratch[k] = j;
+				j = jsmn_canon_skip(c->tokens, c->num_tokens, j);
+			}
+			jsmn_canon_sort(c->js, c->tokens, scratch, n);
+			jsmn_write_raw(c->w, "{", 1);
+			for (k = 0; k < n; k++) {
+				const jsmntok_t *key = &c->tokens[scratch[k]];
+				if (k > 0) {
+					jsmn_write_raw(c->w, ",", 1);
+				}
+				jsmn_canon_string(c->w, c->js + key->start, key->end - key->start);
+				jsmn_write_raw(c->w, ":", 1);
+				if (scratch[k] + 1 >= c->num_tokens ||
+						jsmn_canon_value(c, scratch[k] + 1, scratch + n) < 0) {
+					return JSMN_ERROR_INVAL;
+				}
+			}
+			jsmn_write_raw(c->w, "}", 1);
+			return j;
+		case JSMN_ARRAY:
+			jsmn_write_raw(c->w, "[", 1);
+			for (k = 0; k < n; k++) {
+				if (k > 0) {
+					jsmn_write_raw(c->w, ",", 1);
+				}
+				if (j >= c->num_tokens ||
+						(j = jsmn_canon_value(c, j, scratch)) < 0) {
+					return JSMN_ERROR_INVAL;
+				}
+			}
+			jsmn_write_raw(c->w, "]", 1);
+			return j;
+		case JSMN_STRING:
+			if (n != 0) {
+				return JSMN_ERROR_INVAL;
+			}
+			jsmn_canon_string(c->w, s, len);
+			return j;
+		default:
+			if ((len == 4 && memcmp(s, "true", 4) == 0) ||
+					(len == 5 && memcmp(s, "false", 5) == 0) ||
+					(len == 4 && memcmp(s, "null", 4) == 0)) {
+				jsmn_write_raw(c->w, s, len);
+				return j;
+			}
+			if (n != 0 || jsmn_canon_number(c->w, s, len) < 0) {
+				return JSMN_ERROR_INVAL;
+			}
+			return j;
+	}
+}
+
+int jsmn_canonicalize(jsmn_writer *w, const char *js,
+		const jsmntok_t *tokens, int num_tokens, int *scratch) {
+	struct jsmn_canon c;
+
+	if (num_tokens <= 0) {
+		return JSMN_ERROR_INVAL;
+	}
+	c.w = w;
+	c.js = js;
+	c.tokens = tokens;
+	c.num_tokens = num_tokens;
+	if (jsmn_canon_value(&c, 0, scratch) < 0) {
+		return JSMN_ERROR_INVAL;
+	}
+	return (int) w->len;
+}
@@ -0,0 +1,45 @@
+#ifndef __JSMN_CANON_H_
+#define __JSMN_CANON_H_
+
+#include "jsmn.h"
+#include "jsmn_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Writes the value at tokens[0] without whitespace outside of strings.
+ * Strings are copied as they are, the text between them is compacted 16
+ * bytes at a time with SSE2 where available. The output is never longer
+ * than the value, so a buffer of tokens[0] length always fits. Returns the
+ * length of the output (larger than the buffer if it did not fit), or
+ * JSMN_ERROR_INVAL if there are no tokens.
+ */
+int jsmn_minify(jsmn_writer *w, const char *js, const jsmntok_t *tokens,
+		int num_tokens);
+
+/**
+ * Writes the value at tokens[0] in canonical form, so documents that mean
+ * the same are written to the same bytes, e.g. for hashing:
+ * 	o no whitespace outside of strings
+ * 	o object members sorted by the bytes of their canonical keys, members
+ * 	  with equal keys stay in document order
+ * 	o strings with escapes only for '"', '\\' and control characters
+ * 	  (\b \f \n \r \t or lowercase \u00xx), everything else as UTF-8
+ * 	o numbers as exact decimals without redundant zeros, sign or
+ * 	  exponent, laid out like JavaScript does: 100, 0.25, 1e+21, 1.5e-7
+ * scratch needs room for num_tokens ints, it holds the member order while
+ * objects are written. The output can be longer than the input (1e9 is
+ * written as 1000000000). Returns the length of the output (larger than the
+ * buffer if it did not fit), or JSMN_ERROR_INVAL for tokens that are not
+ * strict JSON.
+ */
+int jsmn_canonicalize(jsmn_writer *w, const char *js,
+		const jsmntok_t *tokens, int num_tokens, int *scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_CANON_H_ */
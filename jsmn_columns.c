@@ -0,0 +1,618 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsmn_bind.h"
+#include "jsmn_columns.h"
+
+#ifndef JSMN_COLUMNS_REALLOC
+#define JSMN_COLUMNS_REALLOC realloc
+#endif
+#ifndef JSMN_COLUMNS_FREE
+#define JSMN_COLUMNS_FREE free
+#endif
+
+#define JSMN_COL_END(js, len, i) ((i) >= (len) || (js)[i] == '\0')
+#define JSMN_COL_DIGIT(c) ((unsigned int) ((c) - '0') <= 9)
+
+/* Powers of ten a double holds exactly */
+static const double jsmn_col_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static size_t jsmn_col_space(const char *js, size_t len, size_t i) {
+	while (i < len && (js[i] == ' ' || js[i] == '\n' || js[i] == '\r' ||
+				js[i] == '\t')) {
+		i++;
+	}
+	return i;
+}
+
+/**
+ * Finds the closing quote of the string opening at js[*pos]. Sets *escaped
+ * if the string has a backslash.
+ */
+static int jsmn_col_string(const char *js, size_t len, size_t *pos,
+		int *escaped) {
+	size_t i;
+
+	for (i = *pos + 1; !JSMN_COL_END(js, len, i); i++) {
+		if (js[i] == '"') {
+			*pos = i;
+			return 0;
+		}
+		if (js[i] == '\\') {
+			*escaped = 1;
+			i++;
+			if (JSMN_COL_END(js, len, i)) {
+				break;
+			}
+		}
+	}
+	*pos = i;
+	return JSMN_ERROR_PART;
+}
+
+/**
+ * Moves *pos past the value at js[*pos], matching quotes and brackets only.
+ */
+static int jsmn_col_skip(const char *js, size_t len, size_t *pos) {
+	size_t i = *pos;
+	int escaped = 0;
+	int depth = 0;
+	int r;
+
+	if (js[i] != '"' && js[i] != '{' && js[i] != '[') {
+		for (; !JSMN_COL_END(js, len, i) && js[i] != ',' && js[i] != '}' &&
+				js[i] != ']' && js[i] != ' ' && js[i] != '\n' &&
+				js[i] != '\r' && js[i] != '\t'; i++);
+		if (i == *pos) {
+			return JSMN_ERROR_INVAL;
+		}
+		*pos = i;
+		return 0;
+	}
+	for (; !JSMN_COL_END(js, len, i); i++) {
+		switch (js[i]) {
+			case '"':
+				if ((r = jsmn_col_string(js, len, &i, &escaped)) < 0) {
+					*pos = i;
+					return r;
+				}
+				break;
+			case '{':
+			case '[':
+				depth++;
+				break;
+			case '}':
+			case ']':
+				depth--;
+				break;
+			default:
+				break;
+		}
+		if (depth == 0) {
+			*pos = i + 1;
+			return 0;
+		}
+	}
+	*pos = i;
+	return JSMN_ERROR_PART;
+}
+
+/**
+ * Checks the number at js[*pos] by the grammar of jsmn_scan_number() and
+ * moves *pos past it, or to where it goes wrong.
+ */
+static int jsmn_col_number(const char *js, size_t len, size_t *pos,
+		int *integer) {
+	size_t end;
+	int r = jsmn_scan_number(js + *pos, len - *pos, &end, integer);
+
+	*pos += end;
+	if (r == JSMN_ERROR_INVAL && JSMN_COL_END(js, len, *pos)) {
+		return JSMN_ERROR_PART;
+	}
+	return r;
+}
+
+static int jsmn_col_int64(const char *js, size_t len, size_t *pos,
+		long long *v) {
+	unsigned long long limit = (unsigned long long) LLONG_MAX;
+	unsigned long long n = 0;
+	size_t i = *pos;
+	size_t start = *pos;
+	int integer;
+	int r;
+
+	if ((r = jsmn_col_number(js, len, pos, &integer)) < 0) {
+		return r;
+	}
+	if (!integer) {
+		*pos = start;
+		return JSMN_ERROR_INVAL;
+	}
+	if (js[i] == '-') {
+		limit++;
+		i++;
+	}
+	for (; i < *pos; i++) {
+		unsigned int d = (unsigned int) (js[i] - '0');
+		if (n > (limit - d) / 10) {
+			*pos = start;
+			return JSMN_ERROR_INVAL;
+		}
+		n = n * 10 + d;
+	}
+	*v = js[start] == '-' ? (long long) (0 - n) : (long long) n;
+	return 0;
+}
+
+/**
+ * Converts the number at js[*pos]. Up to 19 significant digits and a power
+ * of ten up to 1e22 are exact in a double, so one multiplication or
+ * division is correctly rounded. Anything else goes through strtod().
+ */
+static int jsmn_col_double(const char *js, size_t len, size_t *pos,
+		double *v) {
+	unsigned long long m = 0;
+	size_t i = *pos;
+	size_t start = *pos;
+	int digits = 0;
+	int exact = 1;
+	long e10 = 0;
+	int fraction = 0;
+	int integer;
+	int r;
+	double d;
+
+	if ((r = jsmn_col_number(js, len, pos, &integer)) < 0) {
+		return r;
+	}
+	/* The grammar is checked, only collect the digits */
+	for (i += js[i] == '-'; i < *pos && js[i] != 'e' && js[i] != 'E'; i++) {
+		if (js[i] == '.') {
+			fraction = 1;
+			continue;
+		}
+		if (digits == 19) {
+			exact = 0;
+			continue;
+		}
+		m = m * 10 + (unsigned int) (js[i] - '0');
+		digits += m != 0;
+		e10 -= fraction;
+	}
+	if (i < *pos) {
+		long e = 0;
+		int neg = js[++i] == '-';
+
+		for (i += js[i] == '+' || js[i] == '-'; i < *pos; i++) {
+			if (e < 100000) {
+				e = e * 10 + (js[i] - '0');
+			}
+		}
+		e10 += neg ? -e : e;
+	}
+
+	if (exact && m <= (1ULL << 53) && e10 >= -22 && e10 <= 22) {
+		d = (double) m;
+		d = e10 < 0 ? d / jsmn_col_pow10[-e10] : d * jsmn_col_pow10[e10];
+		*v = js[start] == '-' ? -d : d;
+	} else {
+		char buf[64];
+		char *copy = buf;
+		size_t n = *pos - start;
+
+		if (n >= sizeof(buf) &&
+				(copy = (char *) JSMN_COLUMNS_REALLOC(NULL, n + 1)) == NULL) {
+			return JSMN_ERROR_NOMEM;
+		}
+		memcpy(copy, js + start, n);
+		copy[n] = '\0';
+		*v = strtod(copy, NULL);
+		if (copy != buf) {
+			JSMN_COLUMNS_FREE(copy);
+		}
+	}
+	return 0;
+}
+
+static int jsmn_col_chars(jsmn_column *col, size_t need) {
+	size_t size = col->chars_size ? col->chars_size : 256;
+	char *chars;
+
+	if (need <= col->chars_size) {
+		return 0;
+	}
+	if (need > UINT_MAX) {
+		return JSMN_ERROR_NOMEM;
+	}
+	while (size < need) {
+		size *= 2;
+	}
+	chars = (char *) JSMN_COLUMNS_REALLOC(col->chars, size);
+	if (chars == NULL) {
+		return JSMN_ERROR_NOMEM;
+	}
+	col->chars = chars;
+	col->chars_size = size;
+	return 0;
+}
+
+/**
+ * Stores the value at js[*pos] to row of col. Sets *set unless it is null.
+ */
+static int jsmn_col_value(jsmn_column *col, unsigned int row, const char *js,
+		size_t len, size_t *pos, unsigned char *set) {
+	size_t i = *pos;
+	int escaped = 0;
+	int r;
+
+	if (js[i] == 'n') {
+		if (len - i < 4 || memcmp(js + i, "null", 4) != 0) {
+			return len - i < 4 && strncmp(js + i, "null", len - i) == 0 ?
+				JSMN_ERROR_PART : JSMN_ERROR_INVAL;
+		}
+		*pos = i + 4;
+		*set = 0;
+		if (col->type == JSMN_COLUMN_STRING) {
+			col->offsets[row + 1] = col->offsets[row];
+		}
+		return 0;
+	}
+	switch (col->type) {
+		case JSMN_COLUMN_INT64:
+			if (js[i] != '-' && !JSMN_COL_DIGIT(js[i])) {
+				return JSMN_ERROR_INVAL;
+			}
+			r = jsmn_col_int64(js, len, pos, &col->ints[row]);
+			break;
+		case JSMN_COLUMN_DOUBLE:
+			if (js[i] != '-' && !JSMN_COL_DIGIT(js[i])) {
+				return JSMN_ERROR_INVAL;
+			}
+			r = jsmn_col_double(js, len, pos, &col->doubles[row]);
+			break;
+		case JSMN_COLUMN_STRING: {
+			unsigned int base = col->offsets[row];
+			size_t n;
+
+			if (js[i] != '"') {
+				return JSMN_ERROR_INVAL;
+			}
+			if ((r = jsmn_col_string(js, len, pos, &escaped)) < 0) {
+				return r;
+			}
+			n = *pos - i - 1;
+			if (jsmn_col_chars(col, base + n + 1) < 0) {
+				return JSMN_ERROR_NOMEM;
+			}
+			if (escaped) {
+				r = jsmn_unescape(js + i + 1, n, col->chars + base,
+						col->chars_size - base);
+				if (r < 0) {
+					*pos = i;
+					return JSMN_ERROR_INVAL;
+				}
+				n = (size_t) r;
+			} else {
+				memcpy(col->chars + base, js + i + 1, n);
+			}
+			col->offsets[row + 1] = base + (unsigned int) n;
+			(*pos)++;
+			r = 0;
+			break;
+		}
+		default:
+			return JSMN_ERROR_INVAL;
+	}
+	if (r == 0) {
+		*set = 1;
+	}
+	return r;
+}
+
+/**
+ * Walks the object at js[*pos]. Columns cand[0..num_cand) match the path of
+ * the object, their names at depth are compared with its keys.
+ */
+static int jsmn_col_object(jsmn_columns *loader, const char *js, size_t len,
+		size_t *pos, unsigned int depth, const unsigned char *cand,
+		unsigned int num_cand, unsigned char *set) {
+	unsigned char sub[JSMN_COLUMNS_MAX];
+	size_t i = jsmn_col_space(js, len, *pos + 1);
+	int r;
+
+	if (i < len && js[i] == '}') {
+		*pos = i + 1;
+		return 0;
+	}
+	for (;;) {
+		unsigned int num_sub = 0;
+		unsigned int k;
+		size_t key, key_len;
+		int escaped = 0;
+		int leaf = -1;
+
+		if (JSMN_COL_END(js, len, i)) {
+			r = JSMN_ERROR_PART;
+			goto fail;
+		}
+		if (js[i] != '"') {
+			r = JSMN_ERROR_INVAL;
+			goto fail;
+		}
+		key = i + 1;
+		if ((r = jsmn_col_string(js, len, &i, &escaped)) < 0) {
+			goto fail;
+		}
+		key_len = i - key;
+		i = jsmn_col_space(js, len, i + 1);
+		if (JSMN_COL_END(js, len, i) || js[i] != ':') {
+			r = JSMN_COL_END(js, len, i) ? JSMN_ERROR_PART : JSMN_ERROR_INVAL;
+			goto fail;
+		}
+		i = jsmn_col_space(js, len, i + 1);
+		if (JSMN_COL_END(js, len, i)) {
+			r = JSMN_ERROR_PART;
+			goto fail;
+		}
+
+		for (k = 0; k < num_cand; k++) {
+			const jsmn_column *col = &loader->columns[cand[k]];
+			if (col->length[depth] == key_len &&
+					memcmp(col->path + col->name[depth], js + key,
+						key_len) == 0) {
+				if (col->depth == depth + 1) {
+					leaf = cand[k];
+				} else {
+					sub[num_sub++] = cand[k];
+				}
+			}
+		}
+		if (leaf >= 0) {
+			r = jsmn_col_value(&loader->columns[leaf], loader->num_rows, js,
+					len, &i, &set[leaf]);
+		} else if (num_sub > 0 && js[i] == '{') {
+			r = jsmn_col_object(loader, js, len, &i, depth + 1, sub, num_sub,
+					set);
+		} else {
+			r = jsmn_col_skip(js, len, &i);
+		}
+		if (r < 0) {
+			goto fail;
+		}
+
+		i = jsmn_col_space(js, len, i);
+		if (JSMN_COL_END(js, len, i)) {
+			r = JSMN_ERROR_PART;
+			goto fail;
+		}
+		if (js[i] == '}') {
+			*pos = i + 1;
+			return 0;
+		}
+		if (js[i] != ',') {
+			r = JSMN_ERROR_INVAL;
+			goto fail;
+		}
+		i = jsmn_col_space(js, len, i + 1);
+	}
+
+fail:
+	*pos = i;
+	return r;
+}
+
+/**
+ * Returns bytes of n elements of size, or 0 if they do not fit into size_t
+ * (where it is 32 bits, row counts below INT_MAX may not).
+ */
+static size_t jsmn_col_bytes(size_t n, size_t size) {
+	return n > (size_t) -1 / size ? 0 : n * size;
+}
+
+static int jsmn_col_grow(jsmn_columns *loader) {
+	unsigned int max_rows = loader->max_rows ? loader->max_rows * 2 : 64;
+	unsigned int k;
+
+	if (loader->max_rows > INT_MAX / 2 ||
+			jsmn_col_bytes(max_rows, sizeof(long long)) == 0 ||
+			jsmn_col_bytes(max_rows, sizeof(double)) == 0 ||
+			jsmn_col_bytes((size_t) max_rows + 1, sizeof(unsigned int)) == 0) {
+		return JSMN_ERROR_NOMEM;
+	}
+	for (k = 0; k < loader->num_columns; k++) {
+		jsmn_column *col = &loader->columns[k];
+		unsigned char *valid;
+
+		if (col->type == JSMN_COLUMN_INT64) {
+			long long *ints = (long long *) JSMN_COLUMNS_REALLOC(col->ints,
+					jsmn_col_bytes(max_rows, sizeof(long long)));
+			if (ints == NULL) {
+				return JSMN_ERROR_NOMEM;
+			}
+			col->ints = ints;
+		} else if (col->type == JSMN_COLUMN_DOUBLE) {
+			double *doubles = (double *) JSMN_COLUMNS_REALLOC(col->doubles,
+					jsmn_col_bytes(max_rows, sizeof(double)));
+			if (doubles == NULL) {
+				return JSMN_ERROR_NOMEM;
+			}
+			col->doubles = doubles;
+		} else {
+			unsigned int *offsets = (unsigned int *) JSMN_COLUMNS_REALLOC(
+					col->offsets, jsmn_col_bytes((size_t) max_rows + 1,
+						sizeof(unsigned int)));
+			if (offsets == NULL) {
+				return JSMN_ERROR_NOMEM;
+			}
+			if (col->offsets == NULL) {
+				offsets[0] = 0;
+			}
+			col->offsets = offsets;
+		}
+		valid = (unsigned char *) JSMN_COLUMNS_REALLOC(col->valid,
+				max_rows / 8);
+		if (valid == NULL) {
+			return JSMN_ERROR_NOMEM;
+		}
+		col->valid = valid;
+	}
+	loader->max_rows = max_rows;
+	return 0;
+}
+
+int jsmn_columns_init(jsmn_columns *loader, jsmn_column *columns,
+		unsigned int num_columns) {
+	unsigned int i, j, k;
+
+	if (num_columns > JSMN_COLUMNS_MAX) {
+		return JSMN_ERROR_NOMEM;
+	}
+	loader->columns = columns;
+	loader->num_columns = num_columns;
+	loader->num_rows = 0;
+	loader->max_rows = 0;
+	loader->errpos = 0;
+
+	for (i = 0; i < num_columns; i++) {
+		jsmn_column *col = &columns[i];
+		size_t start = 0;
+		size_t end;
+
+		col->ints = NULL;
+		col->doubles = NULL;
+		col->offsets = NULL;
+		col->chars = NULL;
+		col->valid = NULL;
+		col->chars_size = 0;
+		col->depth = 0;
+		if (col->type < JSMN_COLUMN_INT64 || col->type > JSMN_COLUMN_STRING) {
+			return JSMN_ERROR_INVAL;
+		}
+		for (;;) {
+			for (end = start; col->path[end] != '\0' &&
+					col->path[end] != '.'; end++);
+			if (end == start) {
+				return JSMN_ERROR_INVAL;
+			}
+			if (col->depth == JSMN_COLUMNS_DEPTH || end > USHRT_MAX) {
+				return JSMN_ERROR_NOMEM;
+			}
+			col->name[col->depth] = (unsigned short) start;
+			col->length[col->depth] = (unsigned short) (end - start);
+			col->depth++;
+			if (col->path[end] == '\0') {
+				break;
+			}
+			start = end + 1;
+		}
+
+		/* A path may not be a prefix of another one */
+		for (j = 0; j < i; j++) {
+			const jsmn_column *other = &columns[j];
+			unsigned int depth = col->depth < other->depth ? col->depth :
+				other->depth;
+			for (k = 0; k < depth; k++) {
+				if (col->length[k] != other->length[k] ||
+						memcmp(col->path + col->name[k],
+							other->path + other->name[k], col->length[k]) != 0) {
+					break;
+				}
+			}
+			if (k == depth) {
+				return JSMN_ERROR_INVAL;
+			}
+		}
+	}
+	return 0;
+}
+
+int jsmn_columns_load(jsmn_columns *loader, const char *js, size_t len) {
+	unsigned char cand[JSMN_COLUMNS_MAX];
+	unsigned char set[JSMN_COLUMNS_MAX];
+	unsigned int k;
+	size_t i = 0;
+	int rows = 0;
+	int r;
+
+	for (k = 0; k < loader->num_columns; k++) {
+		cand[k] = (unsigned char) k;
+	}
+	for (;;) {
+		unsigned int row = loader->num_rows;
+		size_t start;
+
+		i = jsmn_col_space(js, len, i);
+		if (JSMN_COL_END(js, len, i)) {
+			break;
+		}
+		if (js[i] != '{') {
+			loader->errpos = i;
+			return JSMN_ERROR_INVAL;
+		}
+		if (row == loader->max_rows && jsmn_col_grow(loader) < 0) {
+			loader->errpos = i;
+			return JSMN_ERROR_NOMEM;
+		}
+		for (k = 0; k < loader->num_columns; k++) {
+			set[k] = 0;
+			if (loader->columns[k].type == JSMN_COLUMN_STRING) {
+				loader->columns[k].offsets[row + 1] =
+					loader->columns[k].offsets[row];
+			}
+		}
+
+		start = i;
+		r = jsmn_col_object(loader, js, len, &i, 0, cand,
+				loader->num_columns, set);
+		if (r < 0) {
+			loader->errpos = r == JSMN_ERROR_PART ? start : i;
+			return r;
+		}
+
+		for (k = 0; k < loader->num_columns; k++) {
+			jsmn_column *col = &loader->columns[k];
+			unsigned char bit = (unsigned char) (1 << (row % 8));
+
+			if (row % 8 == 0) {
+				col->valid[row / 8] = 0;
+			}
+			if (set[k]) {
+				col->valid[row / 8] |= bit;
+			} else if (col->type == JSMN_COLUMN_INT64) {
+				col->ints[row] = 0;
+			} else if (col->type == JSMN_COLUMN_DOUBLE) {
+				col->doubles[row] = 0;
+			}
+		}
+		loader->num_rows++;
+		rows++;
+	}
+	return rows;
+}
+
+void jsmn_columns_free(jsmn_columns *loader) {
+	unsigned int k;
+
+	for (k = 0; k < loader->num_columns; k++) {
+		jsmn_column *col = &loader->columns[k];
+
+		JSMN_COLUMNS_FREE(col->ints);
+		JSMN_COLUMNS_FREE(col->doubles);
+		JSMN_COLUMNS_FREE(col->offsets);
+		JSMN_COLUMNS_FREE(col->chars);
+		JSMN_COLUMNS_FREE(col->valid);
+		col->ints = NULL;
+		col->doubles = NULL;
+		col->offsets = NULL;
+		col->chars = NULL;
+		col->valid = NULL;
+		col->chars_size = 0;
+	}
+	loader->num_rows = 0;
+	loader->max_rows = 0;
+}
@@ -0,0 +1,105 @@
+#ifndef __JSMN_COLUMNS_H_
+#define __JSMN_COLUMNS_H_
+
+#include <stddef.h>
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Column value types:
+ * 	o JSMN_COLUMN_INT64 - long long, from an integer number
+ * 	o JSMN_COLUMN_DOUBLE - double, from any number
+ * 	o JSMN_COLUMN_STRING - unescaped bytes, from a string
+ */
+typedef enum {
+	JSMN_COLUMN_INT64 = 1,
+	JSMN_COLUMN_DOUBLE = 2,
+	JSMN_COLUMN_STRING = 3
+} jsmn_column_type;
+
+#define JSMN_COLUMNS_MAX 64
+#define JSMN_COLUMNS_DEPTH 8
+
+/**
+ * Column filled from one field of every record.
+ * path		member names separated by '.', e.g. "geo.lat" (as they appear
+ * 		in JSON, without escapes)
+ * type		type of the values
+ * ints		values of an JSMN_COLUMN_INT64 column, 0 for null rows
+ * doubles	values of an JSMN_COLUMN_DOUBLE column, 0 for null rows
+ * offsets	row i of an JSMN_COLUMN_STRING column is chars[offsets[i]] up
+ * 		to chars[offsets[i + 1]], empty for null rows
+ * chars	bytes of all strings of the column, not terminated
+ * valid	bit i % 8 of valid[i / 8] is set if row i has a value, it is
+ * 		clear if the field is null or missing
+ * The arrays are allocated by jsmn_columns_load(), the rest of the struct
+ * is private.
+ */
+typedef struct {
+	const char *path;
+	jsmn_column_type type;
+	long long *ints;
+	double *doubles;
+	unsigned int *offsets;
+	char *chars;
+	unsigned char *valid;
+	size_t chars_size; /* allocated bytes of chars */
+	unsigned char depth; /* number of names in path */
+	unsigned short name[JSMN_COLUMNS_DEPTH]; /* offset of each name */
+	unsigned short length[JSMN_COLUMNS_DEPTH];
+} jsmn_column;
+
+#define jsmn_column_valid(column, row) \
+	(((column)->valid[(row) / 8] >> ((row) % 8)) & 1)
+
+/**
+ * Loader of newline delimited JSON records into columns.
+ */
+typedef struct {
+	jsmn_column *columns;
+	unsigned int num_columns;
+	unsigned int num_rows;
+	unsigned int max_rows; /* rows allocated in every column */
+	size_t errpos; /* where the last load failed */
+} jsmn_columns;
+
+/**
+ * Prepares loader for columns and clears their arrays. Returns
+ * JSMN_ERROR_NOMEM for more than JSMN_COLUMNS_MAX columns or paths of more
+ * than JSMN_COLUMNS_DEPTH names and JSMN_ERROR_INVAL for empty names or
+ * duplicate paths.
+ */
+int jsmn_columns_init(jsmn_columns *loader, jsmn_column *columns,
+		unsigned int num_columns);
+
+/**
+ * Appends one row per record of len bytes of js to the columns. Records are
+ * objects separated by whitespace, usually one per line. Each record is
+ * scanned once and converted on the way: only the objects on the path to a
+ * column are checked member by member, other values are skipped by
+ * matching quotes and brackets, without building tokens.
+ *
+ * Returns the number of rows appended, or a negative error:
+ * 	o JSMN_ERROR_INVAL - a record is malformed, or a field has the wrong
+ * 	  type (errpos is where)
+ * 	o JSMN_ERROR_PART - the last record is incomplete (errpos is its
+ * 	  start, load it again once the rest has arrived)
+ * 	o JSMN_ERROR_NOMEM - out of memory or offsets would overflow
+ * Rows of records before the failed one are kept.
+ */
+int jsmn_columns_load(jsmn_columns *loader, const char *js, size_t len);
+
+/**
+ * Frees the arrays of all columns.
+ */
+void jsmn_columns_free(jsmn_columns *loader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_COLUMNS_H_ */
@@ -0,0 +1,243 @@
+#include <string.h>
+
+#include "jsmn_diff.h"
+
+struct jsmn_differ {
+	const jsmn_doc *a;
+	const jsmn_doc *b;
+	int flags;
+	jsmn_change *changes;
+	int max_changes;
+	int count;
+	int stop; /* return at the first change */
+};
+
+/**
+ * Returns index of the first token after the subtree of token i.
+ */
+static int jsmn_diff_skip(const jsmn_doc *doc, int i) {
+	int remaining = 1;
+	while (remaining > 0 && i < doc->num_tokens) {
+		remaining += doc->tokens[i].size - 1;
+		i++;
+	}
+	return i;
+}
+
+/**
+ * Records a change. Returns 1 if the comparison can stop.
+ */
+static int jsmn_diff_emit(struct jsmn_differ *d, jsmn_diff_op op, int a,
+		int b) {
+	if (d->count < d->max_changes) {
+		d->changes[d->count].op = op;
+		d->changes[d->count].a = a;
+		d->changes[d->count].b = b;
+	}
+	d->count++;
+	return d->stop;
+}
+
+/* Token text including the quotes of strings */
+static const char *jsmn_diff_text(const jsmn_doc *doc, int i, size_t *len) {
+	const jsmntok_t *t = &doc->tokens[i];
+	int quoted = t->type == JSMN_STRING;
+
+	*len = t->end - t->start + 2 * quoted;
+	return doc->js + t->start - quoted;
+}
+
+static int jsmn_diff_keycmp(const jsmn_doc *doc, int i, const jsmn_doc *other,
+		int j) {
+	const jsmntok_t *a = &doc->tokens[i];
+	const jsmntok_t *b = &other->tokens[j];
+	size_t alen = a->end - a->start;
+	size_t blen = b->end - b->start;
+	int cmp = memcmp(doc->js + a->start, other->js + b->start,
+			alen < blen ? alen : blen);
+
+	if (cmp == 0 && alen != blen) {
+		cmp = alen < blen ? -1 : 1;
+	}
+	return cmp;
+}
+
+/**
+ * Heap sort of member keys, ties in document order.
+ */
+static void jsmn_diff_sort(const jsmn_doc *doc, int *keys, int n) {
+	int start, end, root, child, t;
+
+	for (start = n / 2 - 1, end = n; end > 1;) {
+		if (start >= 0) {
+			root = start--;
+		} else {
+			end--;
+			t = keys[0];
+			keys[0] = keys[end];
+			keys[end] = t;
+			root = 0;
+		}
+		while ((child = 2 * root + 1) < end) {
+			int cmp;
+			if (child + 1 < end) {
+				cmp = jsmn_diff_keycmp(doc, keys[child], doc, keys[child + 1]);
+				if (cmp < 0 || (cmp == 0 && keys[child] < keys[child + 1])) {
+					child++;
+				}
+			}
+			cmp = jsmn_diff_keycmp(doc, keys[root], doc, keys[child]);
+			if (cmp > 0 || (cmp == 0 && keys[root] > keys[child])) {
+				break;
+			}
+			t = keys[root];
+			keys[root] = keys[child];
+			keys[child] = t;
+			root = child;
+		}
+	}
+}
+
+/**
+ * Collects the keys of the object at token i into keys. Returns index of the
+ * token after the object, or JSMN_ERROR_INVAL.
+ */
+static int jsmn_diff_keys(const jsmn_doc *doc, int i, int *keys) {
+	int n = doc->tokens[i].size;
+	int k;
+
+	for (i++, k = 0; k < n; k++) {
+		if (i + 1 >= doc->num_tokens || doc->tokens[i].size != 1) {
+			return JSMN_ERROR_INVAL;
+		}
+		keys[k] = i;
+		i = jsmn_diff_skip(doc, i);
+	}
+	return i;
+}
+
+static int jsmn_diff_value(struct jsmn_differ *d, int i, int j, int *scratch);
+
+/**
+ * Matches members of objects i and j by key.
+ */
+static int jsmn_diff_unordered(struct jsmn_differ *d, int i, int j,
+		int *scratch) {
+	int m = d->a->tokens[i].size;
+	int n = d->b->tokens[j].size;
+	int *ka = scratch;
+	int *kb = scratch + m;
+	int x = 0, y = 0;
+	int r = 0;
+
+	if (jsmn_diff_keys(d->a, i, ka) < 0 || jsmn_diff_keys(d->b, j, kb) < 0) {
+		return JSMN_ERROR_INVAL;
+	}
+	jsmn_diff_sort(d->a, ka, m);
+	jsmn_diff_sort(d->b, kb, n);
+	while (r == 0 && (x < m || y < n)) {
+		int cmp = x == m ? 1 : y == n ? -1 :
+			jsmn_diff_keycmp(d->a, ka[x], d->b, kb[y]);
+		if (cmp < 0) {
+			r = jsmn_diff_emit(d, JSMN_DIFF_REMOVED, ka[x++] + 1, -1);
+		} else if (cmp > 0) {
+			r = jsmn_diff_emit(d, JSMN_DIFF_ADDED, -1, kb[y++] + 1);
+		} else {
+			r = jsmn_diff_value(d, ka[x++] + 1, kb[y++] + 1, scratch + m + n);
+		}
+	}
+	return r;
+}
+
+/**
+ * Compares children of containers i and j by position.
+ */
+static int jsmn_diff_ordered(struct jsmn_differ *d, int i, int j,
+		int *scratch) {
+	int object = d->a->tokens[i].type == JSMN_OBJECT;
+	int m = d->a->tokens[i].size;
+	int n = d->b->tokens[j].size;
+	int k, r = 0;
+
+	/* Members are compared from the key, elements from the value */
+	for (i++, j++, k = 0; r == 0 && (k < m || k < n); k++) {
+		if ((k < m && i + object >= d->a->num_tokens) ||
+				(k < n && j + object >= d->b->num_tokens)) {
+			return JSMN_ERROR_INVAL;
+		}
+		if (k >= n) {
+			r = jsmn_diff_emit(d, JSMN_DIFF_REMOVED, i + object, -1);
+		} else if (k >= m) {
+			r = jsmn_diff_emit(d, JSMN_DIFF_ADDED, -1, j + object);
+		} else if (object && jsmn_diff_keycmp(d->a, i, d->b, j) != 0) {
+			r = jsmn_diff_emit(d, JSMN_DIFF_REMOVED, i + 1, -1);
+			if (r == 0) {
+				r = jsmn_diff_emit(d, JSMN_DIFF_ADDED, -1, j + 1);
+			}
+		} else {
+			r = jsmn_diff_value(d, i + object, j + object, scratch);
+		}
+		i = k < m ? jsmn_diff_skip(d->a, i) : i;
+		j = k < n ? jsmn_diff_skip(d->b, j) : j;
+	}
+	return r;
+}
+
+static int jsmn_diff_value(struct jsmn_differ *d, int i, int j, int *scratch) {
+	const jsmntok_t *ta = &d->a->tokens[i];
+	const jsmntok_t *tb = &d->b->tokens[j];
+	size_t alen, blen;
+	const char *a = jsmn_diff_text(d->a, i, &alen);
+	const char *b = jsmn_diff_text(d->b, j, &blen);
+
+	/* Same text is the same tree */
+	if (alen == blen && (a == b || memcmp(a, b, alen) == 0)) {
+		return 0;
+	}
+	if (ta->type != tb->type ||
+			(ta->type != JSMN_OBJECT && ta->type != JSMN_ARRAY)) {
+		return jsmn_diff_emit(d, JSMN_DIFF_CHANGED, i, j);
+	}
+	if (ta->type == JSMN_OBJECT && (d->flags & JSMN_DIFF_UNORDERED)) {
+		return jsmn_diff_unordered(d, i, j, scratch);
+	}
+	return jsmn_diff_ordered(d, i, j, scratch);
+}
+
+int jsmn_diff(const jsmn_doc *old_doc, const jsmn_doc *new_doc, int flags,
+		int *scratch, jsmn_change *changes, int max_changes) {
+	struct jsmn_differ d;
+	int r;
+
+	if (old_doc->num_tokens <= 0 || new_doc->num_tokens <= 0) {
+		return JSMN_ERROR_INVAL;
+	}
+	d.a = old_doc;
+	d.b = new_doc;
+	d.flags = flags;
+	d.changes = changes;
+	d.max_changes = max_changes;
+	d.count = 0;
+	d.stop = 0;
+	r = jsmn_diff_value(&d, 0, 0, scratch);
+	return r < 0 ? r : d.count;
+}
+
+int jsmn_equal(const jsmn_doc *old_doc, const jsmn_doc *new_doc, int flags,
+		int *scratch) {
+	struct jsmn_differ d;
+	int r;
+
+	if (old_doc->num_tokens <= 0 || new_doc->num_tokens <= 0) {
+		return JSMN_ERROR_INVAL;
+	}
+	d.a = old_doc;
+	d.b = new_doc;
+	d.flags = flags;
+	d.changes = NULL;
+	d.max_changes = 0;
+	d.count = 0;
+	d.stop = 1;
+	r = jsmn_diff_value(&d, 0, 0, scratch);
+	return r < 0 ? r : d.count == 0;
+}
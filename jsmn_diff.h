@@ -0,0 +1,76 @@
+#ifndef __JSMN_DIFF_H_
+#define __JSMN_DIFF_H_
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Parsed document: the JSON text and its tokens.
+ */
+typedef struct {
+	const char *js;
+	const jsmntok_t *tokens;
+	int num_tokens;
+} jsmn_doc;
+
+/**
+ * Kinds of changes from an old document to a new one:
+ * 	o JSMN_DIFF_CHANGED - value a of the old document became value b
+ * 	o JSMN_DIFF_REMOVED - member or element a is gone (b is -1)
+ * 	o JSMN_DIFF_ADDED - member or element b is new (a is -1)
+ */
+typedef enum {
+	JSMN_DIFF_CHANGED = 1,
+	JSMN_DIFF_REMOVED = 2,
+	JSMN_DIFF_ADDED = 3
+} jsmn_diff_op;
+
+/**
+ * Change found by jsmn_diff(). a and b are token indexes in the old and new
+ * document, for object members those of the values (the key is the token
+ * before).
+ */
+typedef struct {
+	jsmn_diff_op op;
+	int a;
+	int b;
+} jsmn_change;
+
+/**
+ * Compare objects by keys, ignoring the order of their members. Without it
+ * members are compared by position, like array elements.
+ */
+#define JSMN_DIFF_UNORDERED 1
+
+/**
+ * Compares the values at tokens[0] of old and new documents and stores up to
+ * max_changes changes. Subtrees whose text is byte for byte the same are
+ * equal without looking at their tokens. Different scalars, and values of
+ * different types, are one JSMN_DIFF_CHANGED; containers of the same type
+ * are compared member by member, so the changes are as deep as possible.
+ * Strings and numbers are compared as written (canonicalize both documents
+ * first to compare "\\u0041" with "A", or 1.0 with 1).
+ *
+ * With JSMN_DIFF_UNORDERED, members are matched by sorted keys, kept in
+ * scratch, which needs room for old->num_tokens + new->num_tokens ints. It
+ * may be NULL otherwise. Returns the number of changes, which may be more
+ * than max_changes, or JSMN_ERROR_INVAL for a malformed token tree.
+ */
+int jsmn_diff(const jsmn_doc *old_doc, const jsmn_doc *new_doc, int flags,
+		int *scratch, jsmn_change *changes, int max_changes);
+
+/**
+ * Returns 1 if the documents are equal by jsmn_diff(), 0 if not, stopping
+ * at the first difference, or JSMN_ERROR_INVAL.
+ */
+int jsmn_equal(const jsmn_doc *old_doc, const jsmn_doc *new_doc, int flags,
+		int *scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_DIFF_H_ */
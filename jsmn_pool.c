@@ -0,0 +1,117 @@
+#include <limits.h>
+#include <stdlib.h>
+
+#include "jsmn_pool.h"
+
+#ifndef JSMN_POOL_REALLOC
+#define JSMN_POOL_REALLOC realloc
+#endif
+#ifndef JSMN_POOL_FREE
+#define JSMN_POOL_FREE free
+#endif
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && \
+	!defined(__STDC_NO_THREADS__)
+#define JSMN_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__)
+#define JSMN_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define JSMN_THREAD_LOCAL __declspec(thread)
+#else
+#error "jsmn_pool needs thread-local storage"
+#endif
+
+/* Free contexts of the current thread, most recently used first */
+static JSMN_THREAD_LOCAL jsmn_ctx *jsmn_pool_head;
+
+static int jsmn_ctx_resize(jsmn_ctx *ctx, unsigned int num_tokens) {
+	size_t n = num_tokens;
+	jsmntok_t *tokens;
+
+	/* The byte size must not wrap where size_t is as narrow as int, checked
+	 * like jsmn_col_grow() checks column sizes */
+	if (n > (size_t) -1 / sizeof(jsmntok_t)) {
+		return JSMN_ERROR_NOMEM;
+	}
+	tokens = (jsmntok_t *) JSMN_POOL_REALLOC(ctx->tokens,
+			n * sizeof(jsmntok_t));
+	if (tokens == NULL) {
+		return JSMN_ERROR_NOMEM;
+	}
+	ctx->tokens = tokens;
+	ctx->num_tokens = num_tokens;
+	return 0;
+}
+
+jsmn_ctx *jsmn_ctx_get(void) {
+	jsmn_ctx *ctx = jsmn_pool_head;
+
+	if (ctx != NULL) {
+		jsmn_pool_head = ctx->next;
+	} else {
+		ctx = (jsmn_ctx *) JSMN_POOL_REALLOC(NULL, sizeof(jsmn_ctx));
+		if (ctx == NULL) {
+			return NULL;
+		}
+		ctx->tokens = NULL;
+		ctx->num_tokens = 0;
+		ctx->high = 0;
+		ctx->uses = 0;
+	}
+	ctx->next = NULL;
+	jsmn_init(&ctx->parser);
+	return ctx;
+}
+
+void jsmn_ctx_put(jsmn_ctx *ctx) {
+	if (++ctx->uses >= JSMN_POOL_TRIM_INTERVAL) {
+		unsigned int want = ctx->high > JSMN_POOL_MIN ? ctx->high : JSMN_POOL_MIN;
+		if (ctx->num_tokens / 2 > want) {
+			/* A failed shrink keeps the larger array, which is fine */
+			jsmn_ctx_resize(ctx, want);
+		}
+		ctx->high = 0;
+		ctx->uses = 0;
+	}
+	ctx->next = jsmn_pool_head;
+	jsmn_pool_head = ctx;
+}
+
+int jsmn_ctx_parse(jsmn_ctx *ctx, const char *js, size_t len) {
+	int r;
+
+	ctx->parser.pos = 0;
+	ctx->parser.toknext = 0;
+	ctx->parser.toksuper = -1;
+	if (ctx->num_tokens == 0 &&
+			jsmn_ctx_resize(ctx, JSMN_POOL_MIN) < 0) {
+		return JSMN_ERROR_NOMEM;
+	}
+	for (;;) {
+		r = jsmn_parse(&ctx->parser, js, len, ctx->tokens, ctx->num_tokens);
+		/*
+		 * Grow only if the tokens ran out, not for other NOMEM causes, and
+		 * not past UINT_MAX tokens, where doubling would wrap and shrink
+		 */
+		if (r != JSMN_ERROR_NOMEM ||
+				ctx->parser.toknext < ctx->num_tokens ||
+				ctx->num_tokens > UINT_MAX / 2 ||
+				jsmn_ctx_resize(ctx, ctx->num_tokens * 2) < 0) {
+			break;
+		}
+	}
+	if (ctx->parser.toknext > ctx->high) {
+		ctx->high = ctx->parser.toknext;
+	}
+	return r;
+}
+
+void jsmn_pool_trim(void) {
+	jsmn_ctx *ctx;
+
+	while ((ctx = jsmn_pool_head) != NULL) {
+		jsmn_pool_head = ctx->next;
+		JSMN_POOL_FREE(ctx->tokens);
+		JSMN_POOL_FREE(ctx);
+	}
+}
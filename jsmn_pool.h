@@ -0,0 +1,64 @@
+#ifndef __JSMN_POOL_H_
+#define __JSMN_POOL_H_
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Parser context: a parser with its own token array. Contexts are kept in a
+ * per-thread pool, so getting and returning one takes no locks, and the
+ * token array is reused by the next request instead of being allocated
+ * again. The array grows to the largest document seen; every
+ * JSMN_POOL_TRIM_INTERVAL returns it is shrunk back to the largest token
+ * count of that period if it is more than twice as big.
+ */
+typedef struct jsmn_ctx {
+	jsmn_parser parser;
+	jsmntok_t *tokens;
+	unsigned int num_tokens; /* size of tokens */
+	unsigned int high; /* most tokens used since the last shrink check */
+	unsigned int uses; /* returns since the last shrink check */
+	struct jsmn_ctx *next; /* next free context of the pool */
+} jsmn_ctx;
+
+#ifndef JSMN_POOL_MIN
+#define JSMN_POOL_MIN 64
+#endif
+#ifndef JSMN_POOL_TRIM_INTERVAL
+#define JSMN_POOL_TRIM_INTERVAL 256
+#endif
+
+/**
+ * Takes a context from the pool of the calling thread, or allocates a new
+ * one. The parser is initialized with jsmn_init(). Returns NULL if out of
+ * memory.
+ */
+jsmn_ctx *jsmn_ctx_get(void);
+
+/**
+ * Returns ctx to the pool of the calling thread.
+ */
+void jsmn_ctx_put(jsmn_ctx *ctx);
+
+/**
+ * Parses js into ctx->tokens from the beginning, growing the token array
+ * until the document fits. Parser settings (strict, keys, intern) are kept.
+ * Returns the same as jsmn_parse(), JSMN_ERROR_NOMEM only if the array can
+ * not grow.
+ */
+int jsmn_ctx_parse(jsmn_ctx *ctx, const char *js, size_t len);
+
+/**
+ * Frees all contexts in the pool of the calling thread. Call it when the
+ * thread goes idle or exits.
+ */
+void jsmn_pool_trim(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_POOL_H_ */
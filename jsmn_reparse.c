@@ -0,0 +1,111 @@
+#include <string.h>
+
+#include "jsmn_reparse.h"
+
+static int jsmn_reparse_full(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, unsigned int num_tokens) {
+	parser->pos = 0;
+	parser->toknext = 0;
+	parser->toksuper = -1;
+	return jsmn_parse(parser, js, len, tokens, num_tokens);
+}
+
+int jsmn_reparse(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, unsigned int num_tokens, unsigned int count,
+		unsigned int start, unsigned int oldend, unsigned int newend) {
+	jsmn_parser sub;
+	long delta = (long) newend - (long) oldend;
+	long cstart, cend;
+#ifdef JSMN_PARENT_LINKS
+	int cparent;
+#endif
+	unsigned int c, i, last, m, total;
+	int r;
+
+	if (count > num_tokens || oldend < start || newend < start ||
+			(size_t) newend > len) {
+		return jsmn_reparse_full(parser, js, len, tokens, num_tokens);
+	}
+#ifdef JSMN_COMPACT
+	if (len > JSMN_POS_MAX) {
+		return jsmn_reparse_full(parser, js, len, tokens, num_tokens);
+	}
+#endif
+
+	/*
+	 * Tokens are in document order, so the last container that starts
+	 * before the edit and ends after it is the innermost one. Its brackets
+	 * must stay outside of the edited bytes.
+	 */
+	c = count;
+	for (i = 0; i < count && tokens[i].start < (long) start; i++) {
+		if ((tokens[i].type == JSMN_OBJECT || tokens[i].type == JSMN_ARRAY) &&
+				tokens[i].end > (long) oldend) {
+			c = i;
+		}
+	}
+	if (c == count) {
+		return jsmn_reparse_full(parser, js, len, tokens, num_tokens);
+	}
+	cstart = tokens[c].start;
+	cend = tokens[c].end + delta;
+#ifdef JSMN_PARENT_LINKS
+	cparent = tokens[c].parent;
+#endif
+	for (last = c + 1; last < count && tokens[last].start < tokens[c].end;
+			last++);
+
+	/* Count the new tokens of the container first to make room for them */
+	sub = *parser;
+	sub.pos = (unsigned int) cstart;
+	sub.toknext = 0;
+	sub.toksuper = -1;
+	r = jsmn_parse(&sub, js, (size_t) cend, NULL, 0);
+	if (r <= 0) {
+		return jsmn_reparse_full(parser, js, len, tokens, num_tokens);
+	}
+	m = (unsigned int) r;
+	total = count - (last - c) + m;
+	if (total > num_tokens) {
+		return jsmn_reparse_full(parser, js, len, tokens, num_tokens);
+	}
+	memmove(tokens + c + m, tokens + last,
+			(size_t) (count - last) * sizeof(jsmntok_t));
+	/* Key ids belong to tokens, they move along */
+	if (parser->intern != NULL && parser->intern->ids != NULL) {
+		memmove(parser->intern->ids + c + m, parser->intern->ids + last,
+				(size_t) (count - last) * sizeof(int));
+	}
+
+	sub.pos = (unsigned int) cstart;
+	sub.toknext = c;
+	sub.toksuper = -1;
+	r = jsmn_parse(&sub, js, (size_t) cend, tokens, c + m);
+	if (r != (int) (c + m) || tokens[c].end != cend) {
+		return jsmn_reparse_full(parser, js, len, tokens, num_tokens);
+	}
+#ifdef JSMN_PARENT_LINKS
+	tokens[c].parent = cparent;
+#endif
+
+	/* Only the enclosing containers end after the edit */
+	for (i = 0; i < c; i++) {
+		if (tokens[i].end > (long) start) {
+			tokens[i].end += delta;
+		}
+	}
+	for (i = c + m; i < total; i++) {
+		tokens[i].start += delta;
+		tokens[i].end += delta;
+#ifdef JSMN_PARENT_LINKS
+		if (tokens[i].parent >= (long) last) {
+			tokens[i].parent += (long) m - (long) (last - c);
+		}
+#endif
+	}
+
+	parser->pos = (unsigned int) len;
+	parser->toknext = total;
+	parser->toksuper = -1;
+	return (int) total;
+}
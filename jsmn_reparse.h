@@ -0,0 +1,36 @@
+#ifndef __JSMN_REPARSE_H_
+#define __JSMN_REPARSE_H_
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Updates tokens after an edit of the parsed input, without parsing all of
+ * it again. tokens hold count tokens of a complete parse of the old input,
+ * which must be valid JSON, and bytes [start, oldend) of the old input were
+ * replaced by bytes [start, newend) of js.
+ *
+ * Only the smallest object or array around the edited bytes is tokenized,
+ * tokens behind it are moved and their offsets (and parent links) shifted,
+ * and ends of the enclosing containers are adjusted. When the edit is not
+ * inside of a container, or the container no longer parses as a single
+ * value, js is parsed from the beginning.
+ *
+ * The tokens and the return value are the same as jsmn_parse() of js with a
+ * fresh parser would give. parser selects strict mode and is left in the
+ * state of that full parse. With parser->intern set, the key ids of moved
+ * tokens move with them and the keys of the reparsed container are interned
+ * again, so ids are those of a full parse too.
+ */
+int jsmn_reparse(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, unsigned int num_tokens, unsigned int count,
+		unsigned int start, unsigned int oldend, unsigned int newend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_REPARSE_H_ */
@@ -0,0 +1,70 @@
+#include "jsmn_soa.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JSMN_SOA_SSE2
+#endif
+
+unsigned int jsmn_soa_count(const jsmn_soa *soa, unsigned int from,
+		unsigned int to, jsmntype_t type) {
+	const unsigned char *t = soa->type;
+	unsigned int n = 0;
+	unsigned int i = from;
+
+#ifdef JSMN_SOA_SSE2
+	const __m128i key = _mm_set1_epi8((char) type);
+
+	while (i + 16 <= to) {
+		/* Byte counters, summed up before any of them can wrap */
+		__m128i acc = _mm_setzero_si128();
+		unsigned int blocks;
+
+		for (blocks = 0; blocks < 255 && i + 16 <= to; blocks++, i += 16) {
+			__m128i v = _mm_loadu_si128((const __m128i *) (t + i));
+			acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(v, key));
+		}
+		acc = _mm_sad_epu8(acc, _mm_setzero_si128());
+		n += (unsigned int) _mm_cvtsi128_si32(acc) +
+			(unsigned int) _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+	}
+#endif
+	for (; i < to; i++) {
+		n += t[i] == (unsigned char) type;
+	}
+	return n;
+}
+
+unsigned int jsmn_soa_skip(const jsmn_soa *soa, unsigned int num_tokens,
+		unsigned int i) {
+	unsigned int lo, hi, mid;
+
+	/* A key ends before its value does */
+	while (i + 1 < num_tokens && soa->size[i] > 0 &&
+			soa->type[i] != JSMN_OBJECT && soa->type[i] != JSMN_ARRAY) {
+		i++;
+	}
+	lo = i + 1;
+	hi = num_tokens;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (soa->start[mid] < soa->end[i]) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+unsigned int jsmn_soa_gather(const jsmn_soa *soa, unsigned int from,
+		unsigned int to, jsmntype_t type, jsmnint_t *starts, jsmnint_t *ends) {
+	unsigned int n = 0;
+	unsigned int i;
+
+	for (i = from; i < to; i++) {
+		starts[n] = soa->start[i];
+		ends[n] = soa->end[i];
+		n += soa->type[i] == (unsigned char) type;
+	}
+	return n;
+}
@@ -0,0 +1,43 @@
+#ifndef __JSMN_SOA_H_
+#define __JSMN_SOA_H_
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Column scans over tokens stored by jsmn_parse_soa(). They read only the
+ * arrays they need, so a scan over the types touches one byte per token
+ * instead of a whole jsmntok_t. Token ranges are [from, to) by index, the
+ * tokens inside token i are [i + 1, jsmn_soa_skip(soa, num_tokens, i)).
+ */
+
+/**
+ * Returns the number of tokens of the given type in [from, to).
+ */
+unsigned int jsmn_soa_count(const jsmn_soa *soa, unsigned int from,
+		unsigned int to, jsmntype_t type);
+
+/**
+ * Returns the index of the first token after token i and everything inside
+ * of it. Tokens start in increasing order, so this is a binary search.
+ */
+unsigned int jsmn_soa_skip(const jsmn_soa *soa, unsigned int num_tokens,
+		unsigned int i);
+
+/**
+ * Copies start and end of each token of the given type in [from, to) into
+ * starts and ends, e.g. the ranges of all strings. Returns how many were
+ * copied. starts and ends must have room for to - from entries, the copy
+ * writes past the last match to stay free of branches.
+ */
+unsigned int jsmn_soa_gather(const jsmn_soa *soa, unsigned int from,
+		unsigned int to, jsmntype_t type, jsmnint_t *starts, jsmnint_t *ends);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_SOA_H_ */
@@ -0,0 +1,171 @@
+#include <string.h>
+
+#include "jsmn_tape.h"
+
+#ifdef JSMN_PARENT_LINKS
+#define JSMN_TAPE_LINKS 0x100
+#else
+#define JSMN_TAPE_LINKS 0
+#endif
+#ifdef JSMN_COMPACT
+#define JSMN_TAPE_COMPACT 0x200
+#else
+#define JSMN_TAPE_COMPACT 0
+#endif
+
+#define JSMN_TAPE_LAYOUT \
+	((unsigned int) sizeof(jsmntok_t) | JSMN_TAPE_LINKS | JSMN_TAPE_COMPACT)
+
+#define JSMN_U32(x) ((x) & 0xffffffffUL)
+#define JSMN_ROTL32(x, r) JSMN_U32(((x) << (r)) | ((x) >> (32 - (r))))
+
+/*
+ * Fingerprint is two interleaved MurmurHash3 (x86, 32-bit) lanes, so
+ * hashing runs at several bytes per cycle, much faster than parsing.
+ */
+static unsigned long jsmn_tape_mix(unsigned long h, unsigned long k) {
+	k = JSMN_U32(k * 0xcc9e2d51UL);
+	k = JSMN_ROTL32(k, 15);
+	k = JSMN_U32(k * 0x1b873593UL);
+	h ^= k;
+	h = JSMN_ROTL32(h, 13);
+	return JSMN_U32(h * 5 + 0xe6546b64UL);
+}
+
+static unsigned long jsmn_tape_fmix(unsigned long h) {
+	h ^= h >> 16;
+	h = JSMN_U32(h * 0x85ebca6bUL);
+	h ^= h >> 13;
+	h = JSMN_U32(h * 0xc2b2ae35UL);
+	h ^= h >> 16;
+	return h;
+}
+
+static unsigned long jsmn_tape_load32(const unsigned char *p) {
+	return (unsigned long) p[0] | ((unsigned long) p[1] << 8) |
+		((unsigned long) p[2] << 16) | ((unsigned long) p[3] << 24);
+}
+
+static void jsmn_tape_hash(const char *js, size_t len, unsigned int hash[2]) {
+	const unsigned char *p = (const unsigned char *) js;
+	unsigned long h1 = 0x9747b28cUL;
+	unsigned long h2 = 0x5bd1e995UL;
+	unsigned long k1 = 0;
+	unsigned long k2 = 0;
+	size_t i;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		h1 = jsmn_tape_mix(h1, jsmn_tape_load32(p + i));
+		h2 = jsmn_tape_mix(h2, jsmn_tape_load32(p + i + 4));
+	}
+	for (; i < len; i++) {
+		if (i % 8 < 4) {
+			k1 |= (unsigned long) p[i] << (8 * (i % 4));
+		} else {
+			k2 |= (unsigned long) p[i] << (8 * (i % 4));
+		}
+	}
+	h1 = jsmn_tape_mix(h1, k1);
+	h2 = jsmn_tape_mix(h2, k2);
+
+	h1 = JSMN_U32(h1 ^ (unsigned long) len);
+	h2 = JSMN_U32(h2 ^ (unsigned long) len);
+	h1 = JSMN_U32(h1 + h2);
+	h2 = JSMN_U32(h2 + h1);
+	h1 = jsmn_tape_fmix(h1);
+	h2 = jsmn_tape_fmix(h2);
+	hash[0] = (unsigned int) JSMN_U32(h1 + h2);
+	hash[1] = (unsigned int) JSMN_U32(h2 + h1 + h2);
+}
+
+size_t jsmn_tape_size(unsigned int num_tokens) {
+	return sizeof(jsmn_tape) + (size_t) num_tokens * sizeof(jsmntok_t);
+}
+
+int jsmn_tape_write(void *tape, size_t size, const jsmn_parser *parser,
+		const char *js, size_t len, const jsmntok_t *tokens,
+		unsigned int num_tokens) {
+	jsmn_tape *hdr = (jsmn_tape *) tape;
+
+	if (parser->keys != NULL) {
+		return JSMN_ERROR_INVAL;
+	}
+	if (size < jsmn_tape_size(num_tokens) || (unsigned int) len != len) {
+		return JSMN_ERROR_NOMEM;
+	}
+	hdr->magic = JSMN_TAPE_MAGIC;
+	hdr->layout = JSMN_TAPE_LAYOUT;
+	hdr->length = (unsigned int) len;
+	jsmn_tape_hash(js, len, hdr->hash);
+	hdr->num_tokens = num_tokens;
+	hdr->mode = parser->strict ? JSMN_TAPE_STRICT : 0;
+	hdr->reserved = 0;
+	memcpy(hdr + 1, tokens, (size_t) num_tokens * sizeof(jsmntok_t));
+	return (int) jsmn_tape_size(num_tokens);
+}
+
+int jsmn_tape_load(const void *tape, size_t size, const jsmn_parser *parser,
+		const char *js, size_t len, const jsmntok_t **tokens) {
+	const jsmn_tape *hdr = (const jsmn_tape *) tape;
+	const jsmntok_t *t;
+	unsigned int hash[2];
+	unsigned int i;
+
+	if (tape == NULL || size < sizeof(jsmn_tape) ||
+			hdr->magic != JSMN_TAPE_MAGIC || hdr->layout != JSMN_TAPE_LAYOUT ||
+			hdr->mode != (parser->strict ? JSMN_TAPE_STRICT : 0) ||
+			hdr->length != len || hdr->num_tokens > (unsigned int) len ||
+			size < jsmn_tape_size(hdr->num_tokens)) {
+		return JSMN_ERROR_INVAL;
+	}
+	jsmn_tape_hash(js, len, hash);
+	if (hash[0] != hdr->hash[0] || hash[1] != hdr->hash[1]) {
+		return JSMN_ERROR_INVAL;
+	}
+
+	/*
+	 * Never hand out tokens pointing outside of the input, or children and
+	 * parents outside of the tape: children follow their parent
+	 */
+	t = (const jsmntok_t *) (hdr + 1);
+	for (i = 0; i < hdr->num_tokens; i++) {
+		if (t[i].type < JSMN_OBJECT || t[i].type > JSMN_PRIMITIVE ||
+				t[i].start < 0 || t[i].end < t[i].start ||
+				(size_t) t[i].end > len || t[i].size < 0 ||
+				(unsigned int) t[i].size >= hdr->num_tokens - i) {
+			return JSMN_ERROR_INVAL;
+		}
+#ifdef JSMN_PARENT_LINKS
+		if (t[i].parent < -1 || t[i].parent >= (long) i) {
+			return JSMN_ERROR_INVAL;
+		}
+#endif
+	}
+	*tokens = t;
+	return (int) hdr->num_tokens;
+}
+
+int jsmn_parse_cached(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, unsigned int num_tokens,
+		const void *tape, size_t size) {
+	const jsmntok_t *cached;
+	int n;
+
+	if (parser->pos == 0 && parser->toknext == 0 && parser->keys == NULL &&
+			parser->intern == NULL) {
+		n = jsmn_tape_load(tape, size, parser, js, len, &cached);
+		if (n >= 0 && tokens == NULL) {
+			/* counting mode stores no tokens but consumes the input */
+			parser->pos = (unsigned int) len;
+			return n;
+		}
+		if (n >= 0 && (unsigned int) n <= num_tokens) {
+			memcpy(tokens, cached, (size_t) n * sizeof(jsmntok_t));
+			parser->pos = (unsigned int) len;
+			parser->toknext = (unsigned int) n;
+			parser->toksuper = -1;
+			return n;
+		}
+	}
+	return jsmn_parse(parser, js, len, tokens, num_tokens);
+}
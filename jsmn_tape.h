@@ -0,0 +1,79 @@
+#ifndef __JSMN_TAPE_H_
+#define __JSMN_TAPE_H_
+
+#include <stddef.h>
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Tape is a saved token array, so the input does not have to be parsed
+ * again while it stays the same. The layout is a header followed by the
+ * tokens, with no pointers inside, so a tape can be written to a file and
+ * later used straight from a mmap()ed copy. Tapes are in native byte order
+ * and token layout: a tape written by a build with other JSMN_PARENT_LINKS
+ * or JSMN_COMPACT settings or on other architecture is simply rejected.
+ *
+ * A tape also records the mode of the parse, and is only used for a parser
+ * in the same mode.
+ *
+ * The fingerprint is a fast non-cryptographic hash of the input, tapes are
+ * expected to come from a trusted cache. Loading checks that every token
+ * stays inside of the input and its size and parent inside of the tape, so
+ * a damaged tape cannot make readers index out of bounds, but a forged one
+ * can still describe another tree than the input has.
+ */
+typedef struct {
+	unsigned int magic; /* JSMN_TAPE_MAGIC, also detects byte order */
+	unsigned int layout; /* token size and configuration flags */
+	unsigned int length; /* length of the input */
+	unsigned int hash[2]; /* fingerprint of the input */
+	unsigned int num_tokens; /* number of tokens after the header */
+	unsigned int mode; /* JSMN_TAPE_STRICT for a strict parse */
+	unsigned int reserved;
+} jsmn_tape;
+
+#define JSMN_TAPE_MAGIC 0x4a534d32
+#define JSMN_TAPE_STRICT 1
+
+/**
+ * Returns size of a tape holding num_tokens tokens.
+ */
+size_t jsmn_tape_size(unsigned int num_tokens);
+
+/**
+ * Stores tokens of js, parsed by parser, into tape. Returns number of bytes
+ * written, JSMN_ERROR_NOMEM if the tape is smaller than jsmn_tape_size(), or
+ * JSMN_ERROR_INVAL if parser->keys is set (the tokens are not those of a
+ * plain parse).
+ */
+int jsmn_tape_write(void *tape, size_t size, const jsmn_parser *parser,
+		const char *js, size_t len, const jsmntok_t *tokens,
+		unsigned int num_tokens);
+
+/**
+ * Checks that tape was made for js by a parser in the mode of parser and
+ * sets *tokens to point to the tokens inside of the tape. Returns number of
+ * tokens or JSMN_ERROR_INVAL if the tape is damaged, belongs to another
+ * input, mode, or jsmn configuration.
+ */
+int jsmn_tape_load(const void *tape, size_t size, const jsmn_parser *parser,
+		const char *js, size_t len, const jsmntok_t **tokens);
+
+/**
+ * Same as jsmn_parse(), but takes the tokens from tape if it matches js and
+ * parses js only if it does not. tape may be NULL. Parsers with keys or
+ * intern set always parse, since a tape has no key ids and all members.
+ */
+int jsmn_parse_cached(jsmn_parser *parser, const char *js, size_t len,
+		jsmntok_t *tokens, unsigned int num_tokens,
+		const void *tape, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_TAPE_H_ */
@@ -0,0 +1,414 @@
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsmn_writer.h"
+
+void jsmn_writer_init(jsmn_writer *w, char *buf, size_t size) {
+	w->buf = buf;
+	w->size = size;
+	w->len = 0;
+}
+
+void jsmn_write_raw(jsmn_writer *w, const char *s, size_t len) {
+	if (w->len < w->size) {
+		size_t avail = w->size - w->len;
+		memcpy(w->buf + w->len, s, len < avail ? len : avail);
+	}
+	w->len += len;
+}
+
+static void jsmn_write_char(jsmn_writer *w, char c) {
+	if (w->len < w->size) {
+		w->buf[w->len] = c;
+	}
+	w->len++;
+}
+
+void jsmn_write_string(jsmn_writer *w, const char *s, size_t len) {
+	static const char hex[] = "0123456789abcdef";
+	char esc[6];
+	size_t run = 0; /* start of characters not written yet */
+	size_t i;
+
+	jsmn_write_char(w, '\"');
+	for (i = 0; i < len; i++) {
+		unsigned char c = (unsigned char) s[i];
+		if (c >= 32 && c != '\"' && c != '\\') {
+			continue;
+		}
+		jsmn_write_raw(w, s + run, i - run);
+		run = i + 1;
+		esc[0] = '\\';
+		switch (c) {
+			case '\"': esc[1] = '\"'; break;
+			case '\\': esc[1] = '\\'; break;
+			case '\b': esc[1] = 'b'; break;
+			case '\f': esc[1] = 'f'; break;
+			case '\n': esc[1] = 'n'; break;
+			case '\r': esc[1] = 'r'; break;
+			case '\t': esc[1] = 't'; break;
+			default:
+				esc[1] = 'u';
+				esc[2] = '0';
+				esc[3] = '0';
+				esc[4] = hex[c >> 4];
+				esc[5] = hex[c & 15];
+				jsmn_write_raw(w, esc, 6);
+				continue;
+		}
+		jsmn_write_raw(w, esc, 2);
+	}
+	jsmn_write_raw(w, s + run, len - run);
+	jsmn_write_char(w, '\"');
+}
+
+/**
+ * Appends decimal digits of u with a decimal point before the last point
+ * digits.
+ */
+static void jsmn_write_digits(jsmn_writer *w, int neg, unsigned long long u,
+		int point) {
+	char buf[32];
+	int n = sizeof(buf);
+	int i;
+
+	for (i = 0; u != 0 || i <= point; i++) {
+		if (i == point && point > 0) {
+			buf[--n] = '.';
+		}
+		buf[--n] = (char) ('0' + u % 10);
+		u /= 10;
+	}
+	if (neg) {
+		buf[--n] = '-';
+	}
+	jsmn_write_raw(w, buf + n, sizeof(buf) - n);
+}
+
+void jsmn_write_int(jsmn_writer *w, long long v) {
+	unsigned long long u = (unsigned long long) v;
+	if (v < 0) {
+		u = 0ULL - u;
+	}
+	jsmn_write_digits(w, v < 0, u, 0);
+}
+
+void jsmn_write_double(jsmn_writer *w, double v) {
+	static const double pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9
+	};
+	const char *point = localeconv()->decimal_point;
+	const double zero = 0.0;
+	char buf[40];
+	char *dot;
+	double m;
+	long long ll;
+	int k;
+
+	if (v != v || v - v != 0) {
+		/* NaN or infinity */
+		jsmn_write_raw(w, "null", 4);
+		return;
+	}
+	if (v == 0) {
+		/* Only the sign bit tells -0.0 from 0.0 */
+		if (memcmp(&v, &zero, sizeof(v)) != 0) {
+			jsmn_write_raw(w, "-0", 2);
+		} else {
+			jsmn_write_raw(w, "0", 1);
+		}
+		return;
+	}
+	/*
+	 * Values with a few decimals: m / 10^k is correctly rounded just as the
+	 * reader's conversion of the printed digits, so equality means the
+	 * output reads back as v.
+	 */
+	if (v > -1e15 && v < 1e15) {
+		for (k = 0; k < (int) (sizeof(pow10) / sizeof(pow10[0])); k++) {
+			m = v * pow10[k];
+			if (m <= -9007199254740992.0 || m >= 9007199254740992.0) {
+				break;
+			}
+			ll = (long long) m;
+			if ((double) ll == m && (double) ll / pow10[k] == v) {
+				jsmn_write_digits(w, ll < 0,
+						ll < 0 ? 0ULL - (unsigned long long) ll : (unsigned long long) ll,
+						k);
+				return;
+			}
+		}
+	}
+	/*
+	 * Everything else goes through the C library, with the fewest of 15 to
+	 * 17 significant digits that read back (17 always do). printf() and
+	 * strtod() agree on the locale's decimal point, JSON wants '.'.
+	 */
+	for (k = 15; k < 17; k++) {
+		snprintf(buf, sizeof(buf), "%.*g", k, v);
+		if (strtod(buf, NULL) == v) {
+			break;
+		}
+	}
+	if (k == 17) {
+		snprintf(buf, sizeof(buf), "%.17g", v);
+	}
+	if (strcmp(point, ".") != 0 && point[0] != '\0' &&
+			(dot = strstr(buf, point)) != NULL) {
+		*dot = '.';
+		memmove(dot + 1, dot + strlen(point), strlen(dot + strlen(point)) + 1);
+	}
+	jsmn_write_raw(w, buf, strlen(buf));
+}
+
+/*
+ * Serializer state: edits are applied while walking the token tree in
+ * document order, text between them is copied from the input lazily.
+ */
+struct jsmn_serializer {
+	jsmn_writer *w;
+	const char *js;
+	const jsmntok_t *tokens;
+	int num_tokens;
+	const jsmn_edit *edits;
+	int num_edits;
+	int e; /* next edit to apply */
+	size_t cur; /* input before this offset has been written */
+};
+
+/**
+ * Returns index of the first token after the subtree of token i.
+ */
+static int jsmn_subtree_end(const jsmntok_t *tokens, int num_tokens, int i) {
+	int remaining = 1;
+	while (remaining > 0 && i < num_tokens) {
+		remaining += tokens[i].size - 1;
+		i++;
+	}
+	return i;
+}
+
+/* Token text boundaries, including quotes of strings */
+static size_t jsmn_tok_begin(const jsmntok_t *t) {
+	return t->type == JSMN_STRING ? t->start - 1 : t->start;
+}
+
+static size_t jsmn_tok_finish(const jsmntok_t *t) {
+	return t->type == JSMN_STRING ? t->end + 1 : t->end;
+}
+
+static void jsmn_copy_to(struct jsmn_serializer *s, size_t pos) {
+	if (pos > s->cur) {
+		jsmn_write_raw(s->w, s->js + s->cur, pos - s->cur);
+		s->cur = pos;
+	}
+}
+
+static void jsmn_skip_edits(struct jsmn_serializer *s, int end) {
+	while (s->e < s->num_edits && s->edits[s->e].token < end) {
+		s->e++;
+	}
+}
+
+/**
+ * Checks if the member made of key (-1 for array elements) and value
+ * tokens is deleted.
+ */
+static int jsmn_member_deleted(const struct jsmn_serializer *s, int key,
+		int value) {
+	int e;
+	for (e = s->e; e < s->num_edits && s->edits[e].token <= value; e++) {
+		if (s->edits[e].op == JSMN_EDIT_DELETE &&
+				(s->edits[e].token == key || s->edits[e].token == value)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int jsmn_emit(struct jsmn_serializer *s, int i);
+
+/**
+ * Writes children of the object or array token i, returns the number of
+ * children written.
+ */
+static int jsmn_emit_children(struct jsmn_serializer *s, int i, size_t *last) {
+	const jsmntok_t *t = &s->tokens[i];
+	int obj = (t->type == JSMN_OBJECT);
+	int kept = 0;
+	int n, m;
+	int j, k, v, next;
+
+	j = i + 1;
+	for (n = 0; n < t->size && j < s->num_tokens; n++) {
+		v = obj ? j + 1 : j;
+		next = jsmn_subtree_end(s->tokens, s->num_tokens, j);
+		if (v >= s->num_tokens) {
+			break;
+		}
+		if (!jsmn_member_deleted(s, obj ? j : -1, v)) {
+			jsmn_emit(s, j);
+			kept++;
+			*last = jsmn_tok_finish(&s->tokens[v]);
+			j = next;
+			continue;
+		}
+		/* Remove the member with the separator after it, or with the one
+		 * before it if all members that follow are deleted too */
+		k = next;
+		for (m = n + 1; m < t->size && k < s->num_tokens; m++) {
+			if (!jsmn_member_deleted(s, obj ? k : -1, obj ? k + 1 : k)) {
+				break;
+			}
+			k = jsmn_subtree_end(s->tokens, s->num_tokens, k);
+		}
+		if ((m < t->size || (kept == 0 && n + 1 < t->size)) &&
+				next < s->num_tokens) {
+			jsmn_copy_to(s, jsmn_tok_begin(&s->tokens[j]));
+			s->cur = jsmn_tok_begin(&s->tokens[next]);
+		} else {
+			jsmn_copy_to(s, kept ? *last : jsmn_tok_begin(&s->tokens[j]));
+			if (s->cur < jsmn_tok_finish(&s->tokens[v])) {
+				s->cur = jsmn_tok_finish(&s->tokens[v]);
+			}
+		}
+		jsmn_skip_edits(s, next);
+		j = next;
+	}
+	return kept;
+}
+
+/**
+ * Writes token i with its subtree, returns index of the token after it.
+ */
+static int jsmn_emit(struct jsmn_serializer *s, int i) {
+	const jsmntok_t *t = &s->tokens[i];
+	const jsmn_edit *edit;
+	int end = jsmn_subtree_end(s->tokens, s->num_tokens, i);
+	int first, last_insert;
+	size_t last;
+	int kept;
+
+	/* Untouched subtrees are copied later together with the text around */
+	if (s->e == s->num_edits || s->edits[s->e].token >= end) {
+		return end;
+	}
+
+	edit = &s->edits[s->e];
+	if (edit->token == i && edit->op == JSMN_EDIT_REPLACE) {
+		jsmn_copy_to(s, jsmn_tok_begin(t));
+		jsmn_write_raw(s->w, edit->value, edit->valuelen);
+		s->cur = jsmn_tok_finish(t);
+		s->e++;
+		if (t->type != JSMN_OBJECT && t->type != JSMN_ARRAY && t->size == 1 &&
+				i + 1 < s->num_tokens) {
+			/* Renamed object key, its value is written separately */
+			jsmn_skip_edits(s, i + 1);
+			return jsmn_emit(s, i + 1);
+		}
+		jsmn_skip_edits(s, end);
+		return end;
+	}
+
+	if (t->type != JSMN_OBJECT && t->type != JSMN_ARRAY && t->size == 1) {
+		/* Object key, continue with its value */
+		jsmn_skip_edits(s, i + 1);
+		return i + 1 < s->num_tokens ? jsmn_emit(s, i + 1) : end;
+	}
+	if (t->type != JSMN_OBJECT && t->type != JSMN_ARRAY) {
+		jsmn_skip_edits(s, end);
+		return end;
+	}
+
+	/* Insertions into this container come first as they have its index */
+	first = s->e;
+	while (s->e < s->num_edits && s->edits[s->e].token == i) {
+		s->e++;
+	}
+	last_insert = s->e;
+
+	last = t->start + 1;
+	kept = jsmn_emit_children(s, i, &last);
+
+	if (first < last_insert) {
+		jsmn_copy_to(s, last);
+		for (; first < last_insert; first++) {
+			edit = &s->edits[first];
+			if (edit->op != JSMN_EDIT_INSERT) {
+				continue;
+			}
+			if (kept++ > 0) {
+				jsmn_write_char(s->w, ',');
+			}
+			if (t->type == JSMN_OBJECT) {
+				jsmn_write_raw(s->w, edit->key, edit->keylen);
+				jsmn_write_char(s->w, ':');
+			}
+			jsmn_write_raw(s->w, edit->value, edit->valuelen);
+		}
+	}
+	jsmn_skip_edits(s, end);
+	return end;
+}
+
+int jsmn_serialize(jsmn_writer *w, const char *js, size_t len,
+		const jsmntok_t *tokens, int num_tokens,
+		const jsmn_edit *edits, int num_edits) {
+	struct jsmn_serializer s;
+	const jsmntok_t *t;
+	int i;
+
+	for (i = 0; i < num_edits; i++) {
+		if (edits[i].token < 0 || edits[i].token >= num_tokens ||
+				(i > 0 && edits[i].token < edits[i - 1].token)) {
+			return JSMN_ERROR_INVAL;
+		}
+		t = &tokens[edits[i].token];
+		switch (edits[i].op) {
+			case JSMN_EDIT_REPLACE:
+				if (edits[i].value == NULL) {
+					return JSMN_ERROR_INVAL;
+				}
+				break;
+			case JSMN_EDIT_DELETE:
+				break;
+			case JSMN_EDIT_INSERT:
+				if (edits[i].value == NULL ||
+						(t->type != JSMN_OBJECT && t->type != JSMN_ARRAY) ||
+						(t->type == JSMN_OBJECT && edits[i].key == NULL)) {
+					return JSMN_ERROR_INVAL;
+				}
+				break;
+			default:
+				return JSMN_ERROR_INVAL;
+		}
+	}
+
+	s.w = w;
+	s.js = js;
+	s.tokens = tokens;
+	s.num_tokens = num_tokens;
+	s.edits = edits;
+	s.num_edits = num_edits;
+	s.e = 0;
+	s.cur = 0;
+
+	i = 0;
+	while (i < num_tokens) {
+		if (s.e < num_edits && edits[s.e].token == i &&
+				edits[s.e].op == JSMN_EDIT_DELETE) {
+			/* Deleted top-level value */
+			t = &tokens[i];
+			jsmn_copy_to(&s, jsmn_tok_begin(t));
+			s.cur = jsmn_tok_finish(t);
+			i = jsmn_subtree_end(tokens, num_tokens, i);
+			jsmn_skip_edits(&s, i);
+			continue;
+		}
+		i = jsmn_emit(&s, i);
+	}
+	jsmn_copy_to(&s, len);
+	return (int) w->len;
+}
@@ -0,0 +1,95 @@
+#ifndef __JSMN_WRITER_H_
+#define __JSMN_WRITER_H_
+
+#include <stddef.h>
+
+#include "jsmn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * JSON writer over a caller provided buffer. Writes never allocate: output
+ * that does not fit is dropped, but len keeps counting, so after an overflow
+ * (len > size) the caller knows how big the buffer has to be.
+ */
+typedef struct {
+	char *buf; /* output buffer */
+	size_t size; /* size of the output buffer */
+	size_t len; /* bytes written, or needed if greater than size */
+} jsmn_writer;
+
+/**
+ * Edit operations understood by jsmn_serialize().
+ * 	o JSMN_EDIT_REPLACE - replace the token text with value, for an object
+ * 	  key only the key itself is replaced
+ * 	o JSMN_EDIT_DELETE - remove an array element or an object member (the
+ * 	  token may be either the key or the value of the member)
+ * 	o JSMN_EDIT_INSERT - append value (and key, for objects) to the object
+ * 	  or array token
+ */
+typedef enum {
+	JSMN_EDIT_REPLACE = 1,
+	JSMN_EDIT_DELETE = 2,
+	JSMN_EDIT_INSERT = 3
+} jsmn_edit_op;
+
+/**
+ * Single edit of a parsed document.
+ * op		operation
+ * token	index of the token the operation applies to
+ * key		raw JSON text of the member name for insertion into an object,
+ * 		including the quotes
+ * value	raw JSON text of the new value
+ */
+typedef struct {
+	jsmn_edit_op op;
+	int token;
+	const char *key;
+	size_t keylen;
+	const char *value;
+	size_t valuelen;
+} jsmn_edit;
+
+void jsmn_writer_init(jsmn_writer *w, char *buf, size_t size);
+
+/**
+ * Appends bytes as they are.
+ */
+void jsmn_write_raw(jsmn_writer *w, const char *s, size_t len);
+
+/**
+ * Appends a quoted JSON string, escaping quotes, backslashes and control
+ * characters.
+ */
+void jsmn_write_string(jsmn_writer *w, const char *s, size_t len);
+
+void jsmn_write_int(jsmn_writer *w, long long v);
+
+/**
+ * Appends a number that reads back as v: plain digits with the fewest
+ * decimals (up to 9) if v has such a form below 1e15, otherwise printf()'s
+ * %g with the fewest of 15 to 17 significant digits that read back, which
+ * may be longer than needed. The decimal point is '.' in any locale and -0.0
+ * is written as -0. Infinities and NaN are not representable in JSON and are
+ * written as null.
+ */
+void jsmn_write_double(jsmn_writer *w, double v);
+
+/**
+ * Writes the document js (len bytes) parsed into tokens, with the edits
+ * applied. Edits must be sorted by token index, several insertions into one
+ * container are appended in order. Text that is not affected by the edits
+ * is copied from js unchanged. Returns length of the output (which is larger
+ * than the buffer if it did not fit), or JSMN_ERROR_INVAL for bad edits.
+ */
+int jsmn_serialize(jsmn_writer *w, const char *js, size_t len,
+		const jsmntok_t *tokens, int num_tokens,
+		const jsmn_edit *edits, int num_edits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __JSMN_WRITER_H_ */
@@ -0,0 +1,823 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fuzz.h"
+/* Default build of the core, for the modules built on it */
+#define JSMN_IMPLEMENTATION
+#include "../jsmn.h"
+#include "../jsmn_bind.c"
+#include "../jsmn_columns.c"
+#include "../jsmn_writer.c"
+#include "../jsmn_canon.c"
+#include "../jsmn_diff.c"
+
+/*
+ * Differential fuzz harness. Every input is parsed by all jsmn builds in
+ * lenient and strict mode, and by a small reference parser of RFC 8259 JSON:
+ * 	o for valid JSON all builds must return the same and produce the same
+ * 	  tokens, builds with parent links the same parents, and strict mode
+ * 	  must give the tokens of the reference parser
+ * 	o fast paths of each build must agree with its plain parse (see
+ * 	  fuzz_cfg.c), and the C++ parsers with the C one (see fuzz_cpp.cpp)
+ * 	o the columnar loader must load a valid object as one row, with the
+ * 	  value of its first member as the reference parser sees it
+ * 	o minifying must only drop whitespace outside of strings, and the
+ * 	  canonical form must not depend on it and be its own canonical form
+ * 	o a document must equal its minified form, and the changes between
+ * 	  two documents must mirror the changes between them the other way
+ * 	o serializing a document without edits must give it back, and with an
+ * 	  edit valid JSON with the tokens of the edit added or removed
+ * A mismatch aborts, which libFuzzer and AFL report as a crash.
+ *
+ * libFuzzer:	clang -fsanitize=fuzzer -DFUZZ_LIBFUZZER ... (see Makefile)
+ * AFL:		afl-fuzz -i in -o out -- ./test/fuzz @@
+ * Self test:	./test/fuzz -gen N		N generated inputs
+ * Canary:	./test/fuzz -canary		looks for super-linear parse time
+ */
+
+static fuzz_result res_plain, res_links, res_compact;
+static fuzz_result res_cpp, res_cpp_compact;
+static fuzz_tok ref_tok[FUZZ_MAX_TOKENS];
+
+void fuzz_fail(const char *cfg, const char *what, const char *js,
+		size_t len) {
+	fprintf(stderr, "%s: %s\ninput (%lu bytes): %.*s\n", cfg, what,
+			(unsigned long) len, (int) len, js);
+	abort();
+}
+
+/* Reference parser: recursive descent over RFC 8259, jsmn token layout */
+typedef struct {
+	const char *js;
+	size_t len;
+	size_t pos;
+	int n;
+	fuzz_tok *tok;
+} ref_parser;
+
+static void ref_ws(ref_parser *p) {
+	while (p->pos < p->len && (p->js[p->pos] == ' ' || p->js[p->pos] == '\t' ||
+				p->js[p->pos] == '\n' || p->js[p->pos] == '\r')) {
+		p->pos++;
+	}
+}
+
+static int ref_token(ref_parser *p, int type, int start, int parent) {
+	fuzz_tok *t;
+
+	if (p->n >= FUZZ_MAX_TOKENS) {
+		return -1;
+	}
+	t = &p->tok[p->n];
+	t->type = type;
+	t->start = start;
+	t->end = -1;
+	t->size = 0;
+	t->parent = parent;
+	if (parent >= 0) {
+		p->tok[parent].size++;
+	}
+	return p->n++;
+}
+
+static int ref_digits(ref_parser *p) {
+	size_t start = p->pos;
+
+	while (p->pos < p->len && p->js[p->pos] >= '0' && p->js[p->pos] <= '9') {
+		p->pos++;
+	}
+	return p->pos > start;
+}
+
+static int ref_string(ref_parser *p, int parent) {
+	int t = ref_token(p, 3, (int) p->pos + 1, parent);
+	int i;
+
+	if (t < 0) {
+		return -1;
+	}
+	for (p->pos++; p->pos < p->len; p->pos++) {
+		unsigned char c = (unsigned char) p->js[p->pos];
+		if (c == '"') {
+			p->tok[t].end = (int) p->pos++;
+			return t;
+		}
+		if (c < 0x20) {
+			return -1;
+		}
+		if (c == '\\') {
+			if (++p->pos >= p->len) {
+				return -1;
+			}
+			c = (unsigned char) p->js[p->pos];
+			if (c == 'u') {
+				for (i = 0; i < 4; i++) {
+					if (++p->pos >= p->len || !strchr("0123456789abcdefABCDEF",
+								p->js[p->pos])) {
+						return -1;
+					}
+				}
+			} else if (!strchr("\"\\/bfnrt", c) || c == '\0') {
+				return -1;
+			}
+		}
+	}
+	return -1;
+}
+
+static int ref_value(ref_parser *p, int parent) {
+	const char *js = p->js;
+	size_t start;
+	int t;
+
+	ref_ws(p);
+	if (p->pos >= p->len) {
+		return -1;
+	}
+	start = p->pos;
+	switch (js[p->pos]) {
+		case '{': case '[':
+			t = ref_token(p, js[p->pos] == '{' ? 1 : 2, (int) p->pos, parent);
+			if (t < 0) {
+				return -1;
+			}
+			p->pos++;
+			ref_ws(p);
+			if (p->pos < p->len &&
+					js[p->pos] == (p->tok[t].type == 1 ? '}' : ']')) {
+				p->tok[t].end = (int) ++p->pos;
+				return t;
+			}
+			for (;;) {
+				if (p->tok[t].type == 1) {
+					int key;
+					ref_ws(p);
+					if (p->pos >= p->len || js[p->pos] != '"' ||
+							(key = ref_string(p, t)) < 0) {
+						return -1;
+					}
+					ref_ws(p);
+					if (p->pos >= p->len || js[p->pos++] != ':' ||
+							ref_value(p, key) < 0) {
+						return -1;
+					}
+				} else if (ref_value(p, t) < 0) {
+					return -1;
+				}
+				ref_ws(p);
+				if (p->pos >= p->len) {
+					return -1;
+				}
+				if (js[p->pos] == ',') {
+					p->pos++;
+					continue;
+				}
+				if (js[p->pos] != (p->tok[t].type == 1 ? '}' : ']')) {
+					return -1;
+				}
+				p->tok[t].end = (int) ++p->pos;
+				return t;
+			}
+		case '"':
+			return ref_string(p, parent);
+		case 't': case 'f': case 'n':
+			{
+				const char *word = js[p->pos] == 't' ? "true" :
+					js[p->pos] == 'f' ? "false" : "null";
+				size_t n = strlen(word);
+				if (p->len - p->pos < n || memcmp(js + p->pos, word, n) != 0) {
+					return -1;
+				}
+				p->pos += n;
+			}
+			break;
+		default:
+			if (js[p->pos] == '-') {
+				p->pos++;
+			}
+			if (p->pos < p->len && js[p->pos] == '0') {
+				p->pos++;
+			} else if (!ref_digits(p)) {
+				return -1;
+			}
+			if (p->pos < p->len && js[p->pos] == '.') {
+				p->pos++;
+				if (!ref_digits(p)) {
+					return -1;
+				}
+			}
+			if (p->pos < p->len && (js[p->pos] == 'e' || js[p->pos] == 'E')) {
+				p->pos++;
+				if (p->pos < p->len && (js[p->pos] == '+' || js[p->pos] == '-')) {
+					p->pos++;
+				}
+				if (!ref_digits(p)) {
+					return -1;
+				}
+			}
+			break;
+	}
+	t = ref_token(p, 4, (int) start, parent);
+	if (t >= 0) {
+		p->tok[t].end = (int) p->pos;
+	}
+	return t;
+}
+
+/* Returns number of tokens of valid JSON, or -1 */
+static int ref_parse(const char *js, size_t len, fuzz_tok *tok) {
+	ref_parser p;
+
+	p.js = js;
+	p.len = len;
+	p.pos = 0;
+	p.n = 0;
+	p.tok = tok;
+	if (ref_value(&p, -1) < 0) {
+		return -1;
+	}
+	ref_ws(&p);
+	return p.pos == len ? p.n : -1;
+}
+
+int fuzz_valid(const char *js, size_t len) {
+	static fuzz_tok tok[FUZZ_MAX_TOKENS];
+
+	return ref_parse(js, strnlen(js, len), tok) >= 0;
+}
+
+/*
+ * Only valid JSON is compared: on malformed input the builds already disagree
+ * even about the result, e.g. {"a":1}: [0]} is rejected by plain builds, which
+ * scan back for the enclosing token, and accepted with parent links.
+ */
+static void fuzz_compare(const char *cfg, const fuzz_result *a,
+		const fuzz_result *b, int parents, const char *js, size_t len) {
+	int strict, i;
+
+	for (strict = 0; strict < 2; strict++) {
+		if (a->r[strict] != b->r[strict]) {
+			fuzz_fail(cfg, strict ? "strict result differs" :
+					"lenient result differs", js, len);
+		}
+		for (i = 0; i < a->r[strict]; i++) {
+			const fuzz_tok *x = &a->tok[strict][i];
+			const fuzz_tok *y = &b->tok[strict][i];
+			if (x->type != y->type || x->start != y->start ||
+					x->end != y->end || x->size != y->size ||
+					(parents && x->parent != y->parent)) {
+				fuzz_fail(cfg, "tokens differ", js, len);
+			}
+		}
+	}
+}
+
+/*
+ * Loads the valid JSON js as a record, which without columns checks how the
+ * loader skips values, then loads the value of its first member into a
+ * column unless the key repeats.
+ */
+static void fuzz_check_columns(const char *js, size_t len, int n) {
+	char path[64], buf[FUZZ_MAX_LEN + 1];
+	const fuzz_tok *key, *value;
+	jsmn_columns loader;
+	jsmn_column col;
+	int i, r;
+
+	if (ref_tok[0].type != JSMN_OBJECT) {
+		return;
+	}
+	jsmn_columns_init(&loader, &col, 0);
+	if (jsmn_columns_load(&loader, js, len) != 1) {
+		fuzz_fail("columns", "object not loaded", js, len);
+	}
+	if (n < 3 || (size_t) (ref_tok[1].end - ref_tok[1].start) >= sizeof(path)) {
+		return;
+	}
+	key = &ref_tok[1];
+	value = &ref_tok[2];
+	for (i = 2; i < n; i++) {
+		if (ref_tok[i].parent == 0 && ref_tok[i].end - ref_tok[i].start ==
+				key->end - key->start && memcmp(js + ref_tok[i].start,
+					js + key->start, key->end - key->start) == 0) {
+			return;
+		}
+	}
+	memcpy(path, js + key->start, key->end - key->start);
+	path[key->end - key->start] = '\0';
+	if (path[0] == '\0' || strchr(path, '.') != NULL ||
+			(value->type == JSMN_PRIMITIVE && js[value->start] != '-' &&
+			 (js[value->start] < '0' || js[value->start] > '9'))) {
+		return;
+	}
+	col.path = path;
+	col.type = value->type == JSMN_STRING ? JSMN_COLUMN_STRING :
+		JSMN_COLUMN_DOUBLE;
+	jsmn_columns_init(&loader, &col, 1);
+	r = jsmn_columns_load(&loader, js, len);
+	if (value->type == JSMN_OBJECT || value->type == JSMN_ARRAY) {
+		if (r != JSMN_ERROR_INVAL) {
+			fuzz_fail("columns", "container loaded", js, len);
+		}
+	} else if (r != 1 || !jsmn_column_valid(&col, 0)) {
+		fuzz_fail("columns", "member not loaded", js, len);
+	} else if (value->type == JSMN_STRING) {
+		int m = jsmn_unescape(js + value->start, value->end - value->start,
+				buf, sizeof(buf));
+		if (m < 0 || (unsigned int) m != col.offsets[1] ||
+				memcmp(buf, col.chars, m) != 0) {
+			fuzz_fail("columns", "string differs", js, len);
+		}
+	} else {
+		memcpy(buf, js + value->start, value->end - value->start);
+		buf[value->end - value->start] = '\0';
+		if (strtod(buf, NULL) != col.doubles[0]) {
+			fuzz_fail("columns", "number differs", js, len);
+		}
+	}
+	jsmn_columns_free(&loader);
+}
+
+static fuzz_tok canon_ref[FUZZ_MAX_TOKENS];
+static jsmntok_t canon_tok[FUZZ_MAX_TOKENS];
+static int canon_scratch[FUZZ_MAX_TOKENS];
+static char canon_out[3][8 * FUZZ_MAX_LEN];
+
+/* Reference tokens as jsmntok_t */
+static void fuzz_canon_tokens(const fuzz_tok *ref, int n) {
+	int i;
+
+	for (i = 0; i < n; i++) {
+		canon_tok[i].type = (jsmntype_t) ref[i].type;
+		canon_tok[i].start = ref[i].start;
+		canon_tok[i].end = ref[i].end;
+		canon_tok[i].size = ref[i].size;
+	}
+}
+
+/* Canonical form of js into canon_out[k], its length or -1 if too long */
+static int fuzz_canon(const char *js, size_t len, int k) {
+	jsmn_writer w;
+	int n = ref_parse(js, len, canon_ref);
+
+	if (n <= 0) {
+		fuzz_fail("canon", "output is not valid JSON", js, len);
+	}
+	fuzz_canon_tokens(canon_ref, n);
+	jsmn_writer_init(&w, canon_out[k], sizeof(canon_out[k]));
+	if (jsmn_canonicalize(&w, js, canon_tok, n, canon_scratch) < 0) {
+		fuzz_fail("canon", "valid JSON not canonicalized", js, len);
+	}
+	return w.len > w.size ? -1 : (int) w.len;
+}
+
+static void fuzz_check_canon(const char *js, int n) {
+	size_t begin = ref_tok[0].start - (ref_tok[0].type == JSMN_STRING);
+	size_t end = ref_tok[0].end + (ref_tok[0].type == JSMN_STRING);
+	size_t i, m = 0;
+	jsmn_writer w;
+	int quoted = 0;
+	int a, b;
+
+	/* Scalar reference: drop whitespace outside of strings */
+	for (i = begin; i < end; i++) {
+		if (quoted || (js[i] != ' ' && js[i] != '\n' && js[i] != '\r' &&
+					js[i] != '\t')) {
+			canon_out[1][m++] = js[i];
+		}
+		if (js[i] == '"') {
+			quoted = !quoted;
+		} else if (js[i] == '\\' && quoted) {
+			canon_out[1][m++] = js[++i];
+		}
+	}
+	fuzz_canon_tokens(ref_tok, n);
+	jsmn_writer_init(&w, canon_out[0], sizeof(canon_out[0]));
+	if (jsmn_minify(&w, js, canon_tok, n) != (int) m ||
+			memcmp(canon_out[0], canon_out[1], m) != 0) {
+		fuzz_fail("canon", "minified output differs", js, end);
+	}
+
+	a = fuzz_canon(js, end, 1);
+	b = fuzz_canon(canon_out[0], m, 2);
+	if (a != b || (a > 0 && memcmp(canon_out[1], canon_out[2], a) != 0)) {
+		fuzz_fail("canon", "canonical form depends on whitespace", js, end);
+	}
+	if (a > 0) {
+		memcpy(canon_out[0], canon_out[1], a);
+		b = fuzz_canon(canon_out[0], a, 2);
+		if (a != b || memcmp(canon_out[1], canon_out[2], a) != 0) {
+			fuzz_fail("canon", "canonical form is not canonical", js, end);
+		}
+	}
+}
+
+static jsmntok_t diff_tok[3][FUZZ_MAX_TOKENS];
+static char diff_js[2][FUZZ_MAX_LEN];
+static int diff_scratch[2 * FUZZ_MAX_TOKENS];
+static jsmn_change diff_changes[2][2 * FUZZ_MAX_TOKENS];
+static jsmn_doc diff_prev;
+
+static void fuzz_diff_doc(jsmn_doc *doc, const char *js, const fuzz_tok *ref,
+		int n, int k) {
+	int i;
+
+	for (i = 0; i < n; i++) {
+		diff_tok[k][i].type = (jsmntype_t) ref[i].type;
+		diff_tok[k][i].start = ref[i].start;
+		diff_tok[k][i].end = ref[i].end;
+		diff_tok[k][i].size = ref[i].size;
+	}
+	doc->js = js;
+	doc->tokens = diff_tok[k];
+	doc->num_tokens = n;
+}
+
+static int fuzz_diff_mirrors(const jsmn_change *x, const jsmn_change *y) {
+	static const jsmn_diff_op mirror[] = {(jsmn_diff_op) 0, JSMN_DIFF_CHANGED,
+		JSMN_DIFF_ADDED, JSMN_DIFF_REMOVED};
+
+	return y->op == mirror[x->op] && x->a == y->b && x->b == y->a;
+}
+
+static void fuzz_check_diff(const char *js, size_t len, int n) {
+	jsmn_doc a, b;
+	jsmn_writer w;
+	int flags, r, s, i;
+
+	fuzz_diff_doc(&a, js, ref_tok, n, 0);
+	jsmn_writer_init(&w, diff_js[0], sizeof(diff_js[0]));
+	r = jsmn_minify(&w, js, a.tokens, n);
+	fuzz_diff_doc(&b, diff_js[0], canon_ref, ref_parse(diff_js[0], r, canon_ref),
+			1);
+	for (flags = 0; flags <= JSMN_DIFF_UNORDERED; flags++) {
+		if (jsmn_equal(&a, &b, flags, diff_scratch) != 1 ||
+				jsmn_diff(&b, &a, flags, diff_scratch, NULL, 0) != 0) {
+			fuzz_fail("diff", "minified document differs", js, len);
+		}
+		if (diff_prev.num_tokens == 0) {
+			continue;
+		}
+		r = jsmn_diff(&diff_prev, &a, flags, diff_scratch, diff_changes[0],
+				2 * FUZZ_MAX_TOKENS);
+		s = jsmn_diff(&a, &diff_prev, flags, diff_scratch, diff_changes[1],
+				2 * FUZZ_MAX_TOKENS);
+		if (r < 0 || r != s ||
+				jsmn_equal(&diff_prev, &a, flags, diff_scratch) != (r == 0)) {
+			fuzz_fail("diff", "changes are not symmetric", js, len);
+		}
+		for (i = 0; i < r; i++) {
+			const jsmn_change *x = &diff_changes[0][i];
+			const jsmn_change *y = &diff_changes[1][i];
+			if ((x->a < 0) != (x->op == JSMN_DIFF_ADDED) ||
+					(x->b < 0) != (x->op == JSMN_DIFF_REMOVED) ||
+					x->a >= diff_prev.num_tokens || x->b >= n) {
+				fuzz_fail("diff", "change out of range", js, len);
+			}
+			if (fuzz_diff_mirrors(x, y)) {
+				continue;
+			}
+			/* A member replaced by one with another key is removed, then
+			 * the new one added, in both directions */
+			if (i + 1 == r || !fuzz_diff_mirrors(x, y + 1) ||
+					!fuzz_diff_mirrors(x + 1, y)) {
+				fuzz_fail("diff", "changes do not mirror", js, len);
+			}
+			i++;
+		}
+	}
+	memcpy(diff_js[1], js, len);
+	fuzz_diff_doc(&diff_prev, diff_js[1], ref_tok, n, 2);
+}
+
+static char serialize_out[FUZZ_MAX_LEN + 64];
+
+/* Index of the token after the subtree of tok[i] */
+static int fuzz_ref_skip(const fuzz_tok *tok, int i) {
+	int k, n = tok[i].size;
+
+	for (i++, k = 0; k < n; k++) {
+		i = fuzz_ref_skip(tok, i);
+	}
+	return i;
+}
+
+/*
+ * Serializes the valid JSON js without edits, which must give js back, and
+ * with one replacement, deletion and insertion at a token picked by the
+ * length of js, each on its own. The output of an edit must be valid JSON
+ * with the tokens of the edit added or removed.
+ */
+static void fuzz_check_serialize(const char *js, size_t len, int n) {
+	static const char value[] = "[0,{}]"; /* 3 tokens */
+	int k = (int) (len * 31 % (size_t) n);
+	int parent = ref_tok[k].parent;
+	int key = parent >= 0 && ref_tok[parent].type == JSMN_OBJECT;
+	int member = parent >= 0 && ref_tok[parent].type == JSMN_STRING;
+	int size = fuzz_ref_skip(ref_tok, k) - k;
+	jsmn_edit edit;
+	jsmn_writer w;
+	int op, r, expect;
+
+	fuzz_canon_tokens(ref_tok, n);
+	jsmn_writer_init(&w, serialize_out, sizeof(serialize_out));
+	r = jsmn_serialize(&w, js, len, canon_tok, n, NULL, 0);
+	if (r != (int) len || memcmp(serialize_out, js, len) != 0) {
+		fuzz_fail("serialize", "output without edits differs", js, len);
+	}
+	for (op = JSMN_EDIT_REPLACE; op <= JSMN_EDIT_INSERT; op++) {
+		memset(&edit, 0, sizeof(edit));
+		edit.op = (jsmn_edit_op) op;
+		edit.token = k;
+		edit.key = "\"~\"";
+		edit.keylen = 3;
+		edit.value = value;
+		edit.valuelen = sizeof(value) - 1;
+		if (op == JSMN_EDIT_REPLACE && key) {
+			/* Renames the member */
+			edit.value = edit.key;
+			edit.valuelen = edit.keylen;
+			expect = n;
+		} else if (op == JSMN_EDIT_REPLACE) {
+			expect = n - size + 3;
+		} else if (op == JSMN_EDIT_DELETE) {
+			if (k == 0) {
+				continue;
+			}
+			expect = n - size - member;
+		} else {
+			/* Into the value at k or the nearest container around it */
+			while (edit.token >= 0 && ref_tok[edit.token].type != JSMN_OBJECT &&
+					ref_tok[edit.token].type != JSMN_ARRAY) {
+				edit.token = ref_tok[edit.token].parent;
+			}
+			if (edit.token < 0) {
+				continue;
+			}
+			expect = n + 3 + (ref_tok[edit.token].type == JSMN_OBJECT);
+		}
+		jsmn_writer_init(&w, serialize_out, sizeof(serialize_out));
+		r = jsmn_serialize(&w, js, len, canon_tok, n, &edit, 1);
+		if (r < 0 || r > (int) sizeof(serialize_out)) {
+			fuzz_fail("serialize", "edit not applied", js, len);
+		}
+		if (ref_parse(serialize_out, r, canon_ref) != expect) {
+			fuzz_fail("serialize", "edited output does not parse as expected",
+					js, len);
+		}
+		jsmn_writer_init(&w, NULL, 0);
+		if (jsmn_serialize(&w, js, len, canon_tok, n, &edit, 1) != r) {
+			fuzz_fail("serialize", "counted length differs", js, len);
+		}
+	}
+}
+
+static void fuzz_one(const char *data, size_t size) {
+	size_t len;
+	int n, i;
+
+	if (size > FUZZ_MAX_LEN) {
+		return;
+	}
+	/* jsmn stops at '\0' */
+	len = strnlen(data, size);
+	n = ref_parse(data, len, ref_tok);
+
+	fuzz_check_plain(data, size, n >= 0, &res_plain);
+	fuzz_check_links(data, size, n >= 0, &res_links);
+	fuzz_check_compact(data, size, n >= 0, &res_compact);
+	fuzz_check_cpp(data, size, &res_cpp, &res_cpp_compact);
+	fuzz_compare("links/c++", &res_links, &res_cpp, 1, data, size);
+	fuzz_compare("compact/c++", &res_compact, &res_cpp_compact, 1, data,
+			size);
+	if (n < 0) {
+		return;
+	}
+	fuzz_check_columns(data, len, n);
+	fuzz_check_canon(data, n);
+	fuzz_check_diff(data, len, n);
+	fuzz_check_serialize(data, len, n);
+	fuzz_compare("plain/links", &res_plain, &res_links, 0, data, size);
+	fuzz_compare("links/compact", &res_links, &res_compact, 1, data, size);
+
+	/* In strict mode a top-level primitive needs a delimiter after it */
+	if (ref_tok[0].type == 4 && (size_t) ref_tok[0].end == len) {
+		return;
+	}
+	if (res_links.r[1] != n) {
+		fuzz_fail("reference", "valid JSON not parsed in strict mode",
+				data, size);
+	}
+	for (i = 0; i < n; i++) {
+		const fuzz_tok *x = &res_links.tok[1][i];
+		const fuzz_tok *y = &ref_tok[i];
+		if (x->type != y->type || x->start != y->start || x->end != y->end ||
+				x->size != y->size || x->parent != y->parent) {
+			fuzz_fail("reference", "tokens differ", data, size);
+		}
+	}
+}
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size) {
+	fuzz_one((const char *) data, size);
+	return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+static unsigned long fuzz_seed = 1;
+
+static unsigned int fuzz_rand(unsigned int n) {
+	fuzz_seed = fuzz_seed * 6364136223846793005UL + 1442695040888963407UL;
+	return (unsigned int) (fuzz_seed >> 33) % n;
+}
+
+/* Appends a random, mostly valid, JSON value */
+static void fuzz_gen_value(char *buf, size_t *n, size_t max, int depth) {
+	static const char *atoms[] = {
+		"0", "-1", "12.5e-3", "true", "false", "null", "\"\"", "\"a\"",
+		"\"key\"", "\"\\u00e9\\n\"", "\"a\\\"b\"", "tru", "01", "x"
+	};
+	int k, i;
+
+	if (*n + 64 > max) {
+		return;
+	}
+	k = depth > 6 ? 0 : fuzz_rand(4);
+	if (k < 2) {
+		const char *a = atoms[fuzz_rand(sizeof(atoms) / sizeof(atoms[0]))];
+		*n += sprintf(buf + *n, "%s", a);
+		return;
+	}
+	buf[(*n)++] = k == 2 ? '[' : '{';
+	for (i = fuzz_rand(5); i > 0 && *n + 64 < max; i--) {
+		if (k == 3) {
+			*n += sprintf(buf + *n, "\"%c\":%s", 'a' + fuzz_rand(4),
+					fuzz_rand(2) ? " " : "");
+		}
+		fuzz_gen_value(buf, n, max, depth + 1);
+		if (i > 1) {
+			*n += sprintf(buf + *n, ",%s", fuzz_rand(3) ? "" : "\n ");
+		}
+	}
+	buf[(*n)++] = k == 2 ? ']' : '}';
+}
+
+static size_t fuzz_gen(char *buf, size_t max) {
+	static const char structural[] = "{}[]\",: \\0a-";
+	size_t n = 0;
+	int m;
+
+	fuzz_gen_value(buf, &n, max, 0);
+	/* Mutate half of the inputs: overwrite, insert or drop a few bytes */
+	for (m = fuzz_rand(2) ? 0 : 1 + fuzz_rand(3); m > 0 && n > 0; m--) {
+		size_t at = fuzz_rand((unsigned int) n);
+		char c = structural[fuzz_rand(sizeof(structural) - 1)];
+		switch (fuzz_rand(3)) {
+			case 0:
+				buf[at] = c;
+				break;
+			case 1:
+				if (n + 1 < max) {
+					memmove(buf + at + 1, buf + at, n - at);
+					buf[at] = c;
+					n++;
+				}
+				break;
+			default:
+				memmove(buf + at, buf + at + 1, n - at - 1);
+				n--;
+				break;
+		}
+	}
+	buf[n] = '\0';
+	return n;
+}
+
+/*
+ * Performance canary: parses documents of one shape at two sizes, time per
+ * byte should not grow with the size.
+ */
+typedef double (*fuzz_timer)(const char *js, size_t len, int strict,
+		int rounds);
+
+static size_t fuzz_shape(char *buf, int shape, int n) {
+	size_t len = 0;
+	int i;
+
+	switch (shape) {
+		case 0: /* wide array */
+			buf[len++] = '[';
+			for (i = 0; i < n; i++) {
+				len += sprintf(buf + len, "%s1", i ? "," : "");
+			}
+			buf[len++] = ']';
+			break;
+		case 1: /* wide object */
+			buf[len++] = '{';
+			for (i = 0; i < n; i++) {
+				len += sprintf(buf + len, "%s\"k\":1", i ? "," : "");
+			}
+			buf[len++] = '}';
+			break;
+		case 2: /* deep nesting */
+			for (i = 0; i < n; i++) {
+				buf[len++] = '[';
+			}
+			for (i = 0; i < n; i++) {
+				buf[len++] = ']';
+			}
+			break;
+		default: /* array of small objects */
+			buf[len++] = '[';
+			for (i = 0; i < n; i++) {
+				len += sprintf(buf + len, "%s{\"k\":[1]}", i ? "," : "");
+			}
+			buf[len++] = ']';
+			break;
+	}
+	buf[len] = '\0';
+	return len;
+}
+
+static int fuzz_canary(void) {
+	static const char *shapes[] = {
+		"wide array", "wide object", "deep nesting", "array of objects"
+	};
+	static const char *cfgs[] = { "plain", "links", "compact" };
+	static const fuzz_timer timers[] = {
+		fuzz_time_plain, fuzz_time_links, fuzz_time_compact
+	};
+	const int small = 500, big = 4000;
+	char *buf = malloc(big * 16 + 16);
+	int flagged = 0;
+	int shape, cfg, strict;
+
+	if (buf == NULL) {
+		return 3;
+	}
+	for (shape = 0; shape < 4; shape++) {
+		for (cfg = 0; cfg < 3; cfg++) {
+			for (strict = 0; strict < 2; strict++) {
+				size_t l1 = fuzz_shape(buf, shape, small);
+				double t1 = timers[cfg](buf, l1, strict, 400);
+				size_t l2 = fuzz_shape(buf, shape, big);
+				double t2 = timers[cfg](buf, l2, strict, 50);
+				double growth = t1 > 0 ? (t2 / 50 / l2) / (t1 / 400 / l1) : 0;
+
+				if (t1 < 0 || t2 < 0) {
+					/* Too big for compact tokens */
+					continue;
+				}
+
+				/* Linear parsing keeps time per byte; 8x size allows noise */
+				printf("%-16s %-7s %-7s %6.2fx time per byte%s\n",
+						shapes[shape], cfgs[cfg], strict ? "strict" : "lenient",
+						growth, growth > 3 ? "  SUPER-LINEAR" : "");
+				if (growth > 3) {
+					flagged++;
+				}
+			}
+		}
+	}
+	free(buf);
+	return flagged > 0;
+}
+
+int main(int argc, char *argv[]) {
+	static char buf[FUZZ_MAX_LEN + 1];
+	size_t n;
+	int i;
+
+	if (argc > 1 && strcmp(argv[1], "-canary") == 0) {
+		return fuzz_canary();
+	}
+	if (argc > 2 && strcmp(argv[1], "-gen") == 0) {
+		int count = atoi(argv[2]);
+		for (i = 0; i < count; i++) {
+			n = fuzz_gen(buf, sizeof(buf) - 1);
+			fuzz_one(buf, n);
+		}
+		printf("%d generated inputs checked\n", count);
+		return 0;
+	}
+	if (argc == 1) {
+		n = fread(buf, 1, sizeof(buf) - 1, stdin);
+		fuzz_one(buf, n);
+		return 0;
+	}
+	for (i = 1; i < argc; i++) {
+		FILE *f = fopen(argv[i], "rb");
+		if (f == NULL) {
+			perror(argv[i]);
+			return 1;
+		}
+		n = fread(buf, 1, sizeof(buf) - 1, f);
+		fclose(f);
+		fuzz_one(buf, n);
+	}
+	return 0;
+}
+
+#endif /* FUZZ_LIBFUZZER */
@@ -0,0 +1,72 @@
+#ifndef __FUZZ_H__
+#define __FUZZ_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Longest input the harness looks at, and tokens it can hold */
+#define FUZZ_MAX_LEN 4096
+#define FUZZ_MAX_TOKENS (FUZZ_MAX_LEN + 1)
+
+/* Token in a form shared by all configurations */
+typedef struct {
+	int type;
+	int start;
+	int end;
+	int size;
+	int parent; /* -1 in configurations without parent links */
+} fuzz_tok;
+
+/* Results of one configuration for lenient ([0]) and strict ([1]) mode */
+typedef struct {
+	int r[2];
+	fuzz_tok tok[2][FUZZ_MAX_TOKENS];
+} fuzz_result;
+
+/* Aborts with a message, so fuzzers record the input as a crash */
+void fuzz_fail(const char *cfg, const char *what, const char *js, size_t len);
+
+/* Whether js (up to len or '\0') is valid JSON, by the reference parser */
+int fuzz_valid(const char *js, size_t len);
+
+/*
+ * Each configuration of jsmn is built from fuzz_cfg.c into its own object:
+ * 	o plain - backward scans for closing brackets and commas
+ * 	o links - JSMN_PARENT_LINKS
+ * 	o compact - JSMN_COMPACT with JSMN_PARENT_LINKS
+ * fuzz_check_*() parses js in both modes into res and cross-checks the fast
+ * paths of that configuration (token counting, key skipping, key interning,
+ * structures of arrays, tapes, incremental reparse, snapshots) against its
+ * plain parse. Checks that rely on the token tree being well formed only
+ * run when valid is set, since the strict mode still lets through things
+ * like {{"a":1}:2}.
+ *
+ * fuzz_time_*() parses js rounds times and returns seconds, for the
+ * performance canary.
+ */
+void fuzz_check_plain(const char *js, size_t len, int valid,
+		fuzz_result *res);
+void fuzz_check_links(const char *js, size_t len, int valid,
+		fuzz_result *res);
+void fuzz_check_compact(const char *js, size_t len, int valid,
+		fuzz_result *res);
+double fuzz_time_plain(const char *js, size_t len, int strict, int rounds);
+double fuzz_time_links(const char *js, size_t len, int strict, int rounds);
+double fuzz_time_compact(const char *js, size_t len, int strict, int rounds);
+
+/*
+ * Parses js with the lenient and strict policies of jsmn.hpp (fuzz_cpp.cpp)
+ * into res with int tokens like links, and into compact with short tokens
+ * like compact.
+ */
+void fuzz_check_cpp(const char *js, size_t len, fuzz_result *res,
+		fuzz_result *compact);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FUZZ_H__ */
@@ -0,0 +1,420 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Part of the fuzz harness that is built once per jsmn configuration (see
+ * FUZZ_CFG in the Makefile). Public names of the modules are suffixed with
+ * the configuration, so all builds can be linked into one binary.
+ */
+
+#define FUZZ_CAT2(a, b) a##_##b
+#define FUZZ_CAT(a, b) FUZZ_CAT2(a, b)
+#define FUZZ_NAME(x) FUZZ_CAT(x, FUZZ_CFG)
+#define FUZZ_STR2(x) #x
+#define FUZZ_STR(x) FUZZ_STR2(x)
+
+#define jsmn_reparse FUZZ_NAME(jsmn_reparse)
+#define jsmn_tape_size FUZZ_NAME(jsmn_tape_size)
+#define jsmn_tape_write FUZZ_NAME(jsmn_tape_write)
+#define jsmn_tape_load FUZZ_NAME(jsmn_tape_load)
+#define jsmn_parse_cached FUZZ_NAME(jsmn_parse_cached)
+#define jsmn_soa_count FUZZ_NAME(jsmn_soa_count)
+#define jsmn_soa_skip FUZZ_NAME(jsmn_soa_skip)
+#define jsmn_soa_gather FUZZ_NAME(jsmn_soa_gather)
+
+#define JSMN_STATIC
+#include "../jsmn.h"
+#include "../jsmn_reparse.c"
+#include "../jsmn_tape.c"
+#include "../jsmn_soa.c"
+#include "fuzz.h"
+
+#define CFG FUZZ_STR(FUZZ_CFG)
+
+static jsmntok_t tok[FUZZ_MAX_TOKENS];
+static jsmntok_t tok2[FUZZ_MAX_TOKENS];
+static jsmntok_t expected[FUZZ_MAX_TOKENS];
+static char edited[FUZZ_MAX_LEN + 1];
+static int ids[FUZZ_MAX_TOKENS];
+static unsigned char soa_type[FUZZ_MAX_TOKENS];
+static jsmnint_t soa_start[FUZZ_MAX_TOKENS], soa_end[FUZZ_MAX_TOKENS];
+static jsmnint_t soa_size[FUZZ_MAX_TOKENS], soa_parent[FUZZ_MAX_TOKENS];
+static jsmnint_t gathered[2][FUZZ_MAX_TOKENS], ranges[2][FUZZ_MAX_TOKENS];
+static double tape[(sizeof(jsmn_tape) + sizeof(tok)) / sizeof(double) + 1];
+
+static int fuzz_same(const jsmntok_t *a, const jsmntok_t *b, int n) {
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (a[i].type != b[i].type || a[i].start != b[i].start ||
+				a[i].end != b[i].end || a[i].size != b[i].size) {
+			return 0;
+		}
+#ifdef JSMN_PARENT_LINKS
+		if (a[i].parent != b[i].parent) {
+			return 0;
+		}
+#endif
+	}
+	return 1;
+}
+
+static int fuzz_parse(const char *js, size_t len, int strict,
+		const jsmn_keyset *keys, jsmn_intern *intern, jsmntok_t *t) {
+	jsmn_parser p;
+
+	jsmn_init(&p);
+	p.strict = strict;
+	p.keys = keys;
+	p.intern = intern;
+	return jsmn_parse(&p, js, len, t, t == NULL ? 0 : FUZZ_MAX_TOKENS);
+}
+
+/* Index of the token after the subtree of t[i] */
+static int fuzz_skip(const jsmntok_t *t, int i) {
+	int k, n = t[i].size;
+
+	for (i++, k = 0; k < n; k++) {
+		i = fuzz_skip(t, i);
+	}
+	return i;
+}
+
+/* What a parse with keys should give: t[i] without members not in set */
+static int fuzz_filter(const char *js, const jsmntok_t *t, int i,
+		const jsmn_keyset *set, jsmntok_t *out, int *m, int parent) {
+	int self = (*m)++;
+	int j = i + 1;
+	int k;
+
+	out[self] = t[i];
+	out[self].size = 0;
+#ifdef JSMN_PARENT_LINKS
+	out[self].parent = parent;
+#else
+	(void) parent;
+#endif
+	for (k = 0; k < t[i].size; k++) {
+		if (t[i].type == JSMN_OBJECT && jsmn_keyset_find(set,
+					js + t[j].start, t[j].end - t[j].start) < 0) {
+			j = fuzz_skip(t, j);
+			continue;
+		}
+		j = fuzz_filter(js, t, j, set, out, m, self);
+		out[self].size++;
+	}
+	return j;
+}
+
+static void fuzz_check_keys(const char *js, size_t len, int r) {
+	static char buf[FUZZ_MAX_LEN * 2];
+	const char *names[JSMN_KEYSET_MAX];
+	jsmn_keyset set;
+	size_t used = 0;
+	int num_names = 0;
+	int seen = 0;
+	int i, j, l, m, n;
+
+	/* Keep every other distinct key name */
+	for (i = 0; i < r && num_names < JSMN_KEYSET_MAX; i++) {
+		if (tok[i].type != JSMN_STRING || tok[i].size != 1) {
+			continue;
+		}
+		l = tok[i].end - tok[i].start;
+		for (j = 0; j < i; j++) {
+			if (tok[j].type == JSMN_STRING && tok[j].size == 1 &&
+					tok[j].end - tok[j].start == l &&
+					memcmp(js + tok[j].start, js + tok[i].start, l) == 0) {
+				break;
+			}
+		}
+		if (j == i && seen++ % 2 == 0) {
+			memcpy(buf + used, js + tok[i].start, l);
+			buf[used + l] = '\0';
+			names[num_names++] = buf + used;
+			used += l + 1;
+		}
+	}
+	if (jsmn_keyset_init(&set, names, num_names) != 0) {
+		return;
+	}
+
+	m = 0;
+	for (i = 0; i < r; ) {
+		i = fuzz_filter(js, tok, i, &set, expected, &m, -1);
+	}
+	n = fuzz_parse(js, len, 1, &set, NULL, tok2);
+	if (n != m || !fuzz_same(tok2, expected, m)) {
+		fuzz_fail(CFG, "parse with keys differs from filtered tokens", js, len);
+	}
+	if (fuzz_parse(js, len, 1, &set, NULL, NULL) != m) {
+		fuzz_fail(CFG, "token count with keys differs", js, len);
+	}
+}
+
+static void fuzz_check_intern(const char *js, size_t len, int strict,
+		int check_ids, int r) {
+	static jsmn_intern_slot slots[1024];
+	static char names[FUZZ_MAX_LEN];
+	jsmn_intern in;
+	int i, n;
+
+	jsmn_intern_init(&in, slots, 1024, names, sizeof(names));
+	in.ids = ids;
+	for (i = 0; i < r; i++) {
+		ids[i] = -2;
+	}
+	n = fuzz_parse(js, len, strict, NULL, &in, tok2);
+	if (n != r || !fuzz_same(tok, tok2, r)) {
+		fuzz_fail(CFG, "parse with interning differs", js, len);
+	}
+	if (!check_ids) {
+		return;
+	}
+	for (i = 0; i < r; i++) {
+		int key = tok[i].type == JSMN_STRING && tok[i].size == 1;
+		if (ids[i] != (key ? jsmn_intern_key(&in, js + tok[i].start,
+						tok[i].end - tok[i].start) : -2)) {
+			fuzz_fail(CFG, "wrong key id", js, len);
+		}
+	}
+}
+
+static void fuzz_check_tape(const char *js, size_t len, int strict, int r) {
+	const jsmntok_t *t;
+	jsmn_parser p;
+	int n;
+
+	jsmn_init(&p);
+	p.strict = strict;
+	n = jsmn_tape_write(tape, sizeof(tape), &p, js, len, tok, r);
+	if (n < 0 || jsmn_tape_load(tape, n, &p, js, len, &t) != r ||
+			!fuzz_same(t, tok, r)) {
+		fuzz_fail(CFG, "tape does not load back", js, len);
+	}
+	/* A tape of the other mode is never used */
+	p.strict = !strict;
+	if (jsmn_tape_load(tape, n, &p, js, len, &t) != JSMN_ERROR_INVAL) {
+		fuzz_fail(CFG, "tape of the other mode loads", js, len);
+	}
+}
+
+/*
+ * The structure of arrays must hold the tokens of jsmn_parse(). Without
+ * parent links jsmn_parse() finds enclosing tokens differently, which only
+ * gives the same tokens for valid JSON.
+ */
+static void fuzz_check_soa(const char *js, size_t len, int strict, int valid,
+		int r) {
+	jsmn_soa soa;
+	jsmn_parser p;
+	unsigned int from, to, n, k;
+	int i;
+
+	soa.type = soa_type;
+	soa.start = soa_start;
+	soa.end = soa_end;
+	soa.size = soa_size;
+	soa.parent = soa_parent;
+	jsmn_init(&p);
+	p.strict = strict;
+	n = jsmn_parse_soa(&p, js, len, &soa, FUZZ_MAX_TOKENS);
+#ifndef JSMN_PARENT_LINKS
+	if (!valid) {
+		return;
+	}
+#endif
+	if ((int) n != r) {
+		fuzz_fail(CFG, "structure of arrays: result differs", js, len);
+	}
+	for (i = 0; i < r; i++) {
+		if (soa_type[i] != tok[i].type || soa_start[i] != tok[i].start ||
+				soa_end[i] != tok[i].end || soa_size[i] != tok[i].size) {
+			fuzz_fail(CFG, "structure of arrays: tokens differ", js, len);
+		}
+#ifdef JSMN_PARENT_LINKS
+		if (soa_parent[i] != tok[i].parent) {
+			fuzz_fail(CFG, "structure of arrays: parents differ", js, len);
+		}
+#endif
+	}
+	if (!valid || r <= 0) {
+		return;
+	}
+
+	for (i = 0; i < r; i++) {
+		if (jsmn_soa_skip(&soa, n, i) != (unsigned int) fuzz_skip(tok, i)) {
+			fuzz_fail(CFG, "jsmn_soa_skip() differs", js, len);
+		}
+	}
+	from = (unsigned int) len % n;
+	to = from + (n - from) / 2 + 1;
+	for (k = JSMN_OBJECT; k <= JSMN_PRIMITIVE; k++) {
+		unsigned int m = 0;
+		for (i = from; i < (int) to; i++) {
+			if (tok[i].type == k) {
+				gathered[0][m] = tok[i].start;
+				gathered[1][m++] = tok[i].end;
+			}
+		}
+		if (jsmn_soa_count(&soa, from, to, (jsmntype_t) k) != m ||
+				jsmn_soa_gather(&soa, from, to, (jsmntype_t) k, ranges[0],
+					ranges[1]) != m ||
+				memcmp(ranges[0], gathered[0], m * sizeof(jsmnint_t)) != 0 ||
+				memcmp(ranges[1], gathered[1], m * sizeof(jsmnint_t)) != 0) {
+			fuzz_fail(CFG, "column scans differ", js, len);
+		}
+	}
+}
+
+/*
+ * Inserts and removes a few bytes chosen from the input and checks that
+ * reparsing gives the same as parsing from scratch. Reparsing needs the old
+ * input to be valid JSON.
+ */
+static void fuzz_check_reparse(const char *js, size_t len, int strict,
+		int valid, int r) {
+	unsigned int h = JSMN_FNV_BASIS;
+	unsigned int a, d;
+	jsmn_parser p;
+	size_t i;
+	int old, n;
+
+	for (i = 0; i < len; i++) {
+		h = (h ^ (unsigned char) js[i]) * JSMN_FNV_PRIME;
+	}
+	a = h % (unsigned int) (len + 1);
+	d = (h >> 24) % 8;
+	if (d > len - a) {
+		d = (unsigned int) (len - a);
+	}
+	memcpy(edited, js, a);
+	memcpy(edited + a, js + a + d, len - a - d);
+
+	/* js is the edited text with d bytes inserted at a */
+	old = fuzz_parse(edited, len - d, strict, NULL, NULL, tok2);
+	if (old >= 0 && fuzz_valid(edited, len - d)) {
+		jsmn_init(&p);
+		p.strict = strict;
+		n = jsmn_reparse(&p, js, len, tok2, FUZZ_MAX_TOKENS, old, a, a, a + d);
+		if (n != r || (r > 0 && !fuzz_same(tok2, tok, r))) {
+			fuzz_fail(CFG, "reparse after insertion differs", js, len);
+		}
+	}
+
+	/* And the other way round */
+	if (r >= 0 && valid) {
+		int full = fuzz_parse(edited, len - d, strict, NULL, NULL, expected);
+		memcpy(tok2, tok, r * sizeof(jsmntok_t));
+		jsmn_init(&p);
+		p.strict = strict;
+		n = jsmn_reparse(&p, edited, len - d, tok2, FUZZ_MAX_TOKENS, r,
+				a, a + d, a);
+		if (n != full || (full > 0 && !fuzz_same(tok2, expected, full))) {
+			fuzz_fail(CFG, "reparse after removal differs", js, len);
+		}
+	}
+}
+
+/*
+ * Parses a prefix of js and saves the parser, parses the input with the rest
+ * reversed, restores and parses the real rest: must give what parsing the
+ * rest right after the prefix gives.
+ */
+static void fuzz_check_snapshot(const char *js, size_t len, int strict) {
+	size_t a = len > 0 ? (len * 5 / 8 + (unsigned char) js[0]) % (len + 1) : 0;
+	jsmn_snapshot snap;
+	jsmn_parser p, q;
+	size_t i;
+	int n, m;
+
+	jsmn_init(&p);
+	p.strict = strict;
+	n = jsmn_parse(&p, js, a, tok2, FUZZ_MAX_TOKENS);
+	if ((n < 0 && n != JSMN_ERROR_PART) || jsmn_save(&p, tok2, &snap) != 0) {
+		return;
+	}
+	q = p;
+	memcpy(expected, tok2, p.toknext * sizeof(jsmntok_t));
+	n = jsmn_parse(&q, js, len, expected, FUZZ_MAX_TOKENS);
+
+	memcpy(edited, js, a);
+	for (i = a; i < len; i++) {
+		edited[i] = js[len - 1 - (i - a)];
+	}
+	jsmn_parse(&p, edited, len, tok2, FUZZ_MAX_TOKENS);
+	jsmn_restore(&p, tok2, &snap);
+	m = jsmn_parse(&p, js, len, tok2, FUZZ_MAX_TOKENS);
+	if (m != n || p.pos != q.pos || p.toknext != q.toknext ||
+			p.toksuper != q.toksuper || p.errpos != q.errpos ||
+			!fuzz_same(tok2, expected, q.toknext)) {
+		fuzz_fail(CFG, "parse after restore differs", js, len);
+	}
+}
+
+void FUZZ_NAME(fuzz_check)(const char *js, size_t len, int valid,
+		fuzz_result *res) {
+	int strict, r, i;
+
+	for (strict = 0; strict < 2; strict++) {
+		r = fuzz_parse(js, len, strict, NULL, NULL, tok);
+		res->r[strict] = r;
+		for (i = 0; i < r; i++) {
+			fuzz_tok *t = &res->tok[strict][i];
+			t->type = tok[i].type;
+			t->start = tok[i].start;
+			t->end = tok[i].end;
+			t->size = tok[i].size;
+#ifdef JSMN_PARENT_LINKS
+			t->parent = tok[i].parent;
+#else
+			t->parent = -1;
+#endif
+		}
+
+		fuzz_check_reparse(js, len, strict, valid, r);
+		fuzz_check_soa(js, len, strict, valid, r);
+		fuzz_check_snapshot(js, len, strict);
+		if (r < 0) {
+			continue;
+		}
+		if (fuzz_parse(js, len, strict, NULL, NULL, NULL) != r) {
+			fuzz_fail(CFG, "token count differs from parse", js, len);
+		}
+		fuzz_check_intern(js, len, strict, strict && valid, r);
+		fuzz_check_tape(js, len, strict, r);
+		if (strict && valid) {
+			fuzz_check_keys(js, len, r);
+		}
+	}
+}
+
+double FUZZ_NAME(fuzz_time)(const char *js, size_t len, int strict,
+		int rounds) {
+	static jsmntok_t *t;
+	static unsigned int num;
+	jsmn_parser p;
+	clock_t start;
+	int i, n;
+
+	n = fuzz_parse(js, len, strict, NULL, NULL, NULL);
+	if (n < 0) {
+		return -1;
+	}
+	if ((unsigned int) n > num) {
+		free(t);
+		num = n;
+		t = malloc(num * sizeof(jsmntok_t));
+	}
+	start = clock();
+	for (i = 0; i < rounds; i++) {
+		jsmn_init(&p);
+		p.strict = strict;
+		if (jsmn_parse(&p, js, len, t, num) != n) {
+			return -1;
+		}
+	}
+	return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
@@ -0,0 +1,44 @@
+#include <string_view>
+
+#include "fuzz.h"
+#include "../jsmn.hpp"
+
+/*
+ * C++ parsers of both modes with int and short tokens, all with parent
+ * links, so fuzz.c can check that they give what the C parsers of
+ * fuzz_links.o and fuzz_compact.o give.
+ */
+
+typedef jsmn::policy<false, true, short> lenient_compact;
+
+template <typename Policy>
+static int fuzz_cpp_parse(const char *js, size_t len, fuzz_tok *out) {
+	static typename Policy::token_type tok[FUZZ_MAX_TOKENS];
+	jsmn::parser<Policy> p;
+	std::string_view s(js, len);
+	int r, i;
+
+	r = p.parse(s, tok, FUZZ_MAX_TOKENS);
+	for (i = 0; i < r; i++) {
+		out[i].type = tok[i].type;
+		out[i].start = tok[i].start;
+		out[i].end = tok[i].end;
+		out[i].size = tok[i].size;
+		out[i].parent = tok[i].parent;
+	}
+	p.reset();
+	if (r >= 0 && p.count(s) != r) {
+		fuzz_fail("c++", "token count differs from parse", js, len);
+	}
+	return r;
+}
+
+void fuzz_check_cpp(const char *js, size_t len, fuzz_result *res,
+		fuzz_result *compact) {
+	res->r[0] = fuzz_cpp_parse<jsmn::default_policy>(js, len, res->tok[0]);
+	res->r[1] = fuzz_cpp_parse<jsmn::strict_policy>(js, len, res->tok[1]);
+	compact->r[0] = fuzz_cpp_parse<lenient_compact>(js, len,
+			compact->tok[0]);
+	compact->r[1] = fuzz_cpp_parse<jsmn::compact_policy>(js, len,
+			compact->tok[1]);
+}
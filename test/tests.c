@@ -2,10 +2,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <locale.h>
 
 #include "test.h"
 #include "testutil.h"
 
+#include "../jsmn_writer.c"
+#include "../jsmn_tape.c"
+#include "../jsmn_reparse.c"
+#include "../jsmn_bind.c"
+#include "../jsmn_pool.c"
+#include "../jsmn_soa.c"
+#include "../jsmn_columns.c"
+#include "../jsmn_canon.c"
+#include "../jsmn_diff.c"
+
 int test_empty(void) {
 	check(parse("{}", 1, 1,
 				JSMN_OBJECT, 0, 2, 0));
@@ -385,6 +396,1156 @@ int test_unmatched_brackets(void) {
 	return 0;
 }
 
+int test_runtime_strict(void) {
+	int r;
+	jsmn_parser p;
+	jsmntok_t tok[10];
+	const char *js;
+
+	js = "key1: \"value\"\nkey2 : 123";
+
+	jsmn_init(&p);
+	p.strict = 0;
+	r = jsmn_parse(&p, js, strlen(js), tok, 10);
+	check(r == 4);
+	check(tokeq(js, tok, 4,
+				JSMN_PRIMITIVE, "key1",
+				JSMN_STRING, "value", 0,
+				JSMN_PRIMITIVE, "key2",
+				JSMN_PRIMITIVE, "123"));
+
+	jsmn_init(&p);
+	p.strict = 1;
+	r = jsmn_parse(&p, js, strlen(js), tok, 10);
+	check(r == JSMN_ERROR_INVAL);
+
+	js = "{\"a\": {\"a\": 2 3}}";
+	jsmn_init(&p);
+	p.strict = 1;
+	check(jsmn_parse(&p, js, strlen(js), tok, 10) == JSMN_ERROR_INVAL);
+	jsmn_init(&p);
+	p.strict = 0;
+	check(jsmn_parse(&p, js, strlen(js), tok, 10) == 6);
+
+	/* Strict mode waits for the delimiter after a trailing primitive */
+	js = "[1, 2";
+	jsmn_init(&p);
+	p.strict = 1;
+	check(jsmn_parse(&p, js, strlen(js), tok, 10) == JSMN_ERROR_PART);
+	check(p.pos == 4);
+	return 0;
+}
+
+int test_error_location(void) {
+	jsmn_parser p;
+	jsmntok_t tok[10];
+	jsmn_error err;
+	const char *js;
+
+	js = "{\"a\": 1,\n \"b\": \"x\\qy\"}";
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, strlen(js), tok, 10) == JSMN_ERROR_INVAL);
+	jsmn_get_error(&p, js, &err);
+	check(err.pos == 18 && js[err.pos] == 'q');
+	check(err.line == 2 && err.col == 10);
+	check(err.token == 3);
+
+	js = "[1, 2]\n]";
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, strlen(js), tok, 10) == JSMN_ERROR_INVAL);
+	jsmn_get_error(&p, js, &err);
+	check(err.pos == 7 && err.line == 2 && err.col == 1);
+	check(err.token == 2);
+
+	js = "[1, 2, 3]";
+	jsmn_init(&p);
+	check(jsmn_parse(&p, js, strlen(js), tok, 2) == JSMN_ERROR_NOMEM);
+	jsmn_get_error(&p, js, &err);
+	check(err.pos == 4 && err.token == 1);
+	return 0;
+}
+
+int test_recover(void) {
+	int r;
+	jsmn_parser p;
+	jsmntok_t tok[16];
+	const char *js;
+
+	js = "{\"a\": [1, 2]}\n"
+		"{\"b\": [3, \"\\x\"]}\n"
+		"{\"c\": 4}\n";
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	check(r == JSMN_ERROR_INVAL);
+	check(jsmn_recover(&p, js, strlen(js), tok) == 5);
+	r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	check(r == 8);
+	check(tokeq(js, tok, 8,
+				JSMN_OBJECT, 0, 13, 1,
+				JSMN_STRING, "a", 1,
+				JSMN_ARRAY, 6, 12, 2,
+				JSMN_PRIMITIVE, "1",
+				JSMN_PRIMITIVE, "2",
+				JSMN_OBJECT, 31, 39, 1,
+				JSMN_STRING, "c", 1,
+				JSMN_PRIMITIVE, "4"));
+	return 0;
+}
+
+static int tokens_equal(const jsmntok_t *a, const jsmntok_t *b, int n) {
+	int i;
+	for (i = 0; i < n; i++) {
+		if (a[i].type != b[i].type || a[i].start != b[i].start ||
+				a[i].end != b[i].end || a[i].size != b[i].size) {
+			return 0;
+		}
+#ifdef JSMN_PARENT_LINKS
+		if (a[i].parent != b[i].parent) {
+			return 0;
+		}
+#endif
+	}
+	return 1;
+}
+
+int test_snapshot(void) {
+	const char *js = "[{\"a\": 1}, {\"b\": [2, 3]}, {c: 4}, 5]";
+	const char *other = "[{\"a\": 1}, {\"b\": [2, 3]}, 6]";
+	unsigned int ends[3] = {10, 25, 0};
+	char deep[80];
+	jsmn_snapshot snap;
+	jsmn_parser p;
+	jsmntok_t tok[16], tok2[16], many[80];
+	int r, k;
+
+	/* Checkpoint after each record, strict mode fails on the third */
+	ends[2] = strlen(js);
+	memset(&snap, 0, sizeof(snap));
+	jsmn_init(&p);
+	p.strict = 1;
+	for (k = 0; k < 3; k++) {
+		r = jsmn_parse(&p, js, ends[k], tok, 16);
+		if (r != JSMN_ERROR_PART) {
+			break;
+		}
+		check(jsmn_save(&p, tok, &snap) == 0);
+	}
+	check(k == 2 && r == JSMN_ERROR_INVAL);
+
+	/* Go on leniently from the checkpoint, as if lenient from the start */
+	jsmn_restore(&p, tok, &snap);
+	check(p.pos == 25 && p.toknext == 9);
+	p.strict = 0;
+	r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	check(r == 13);
+	jsmn_init(&p);
+	p.strict = 0;
+	check(jsmn_parse(&p, js, strlen(js), tok2, 16) == 13);
+	check(tokens_equal(tok, tok2, 13));
+
+	/* Other input with the same start */
+	jsmn_restore(&p, tok, &snap);
+	r = jsmn_parse(&p, other, strlen(other), tok, 16);
+	check(r == 10);
+	check(tok[0].size == 3 && tok[4].end == 24 &&
+			tokeq(other, tok + 9, 1, JSMN_PRIMITIVE, "6"));
+	jsmn_restore(&p, tok, &snap);
+	p.strict = 0;
+	check(jsmn_parse(&p, js, strlen(js), tok, 16) == 13);
+	check(tokens_equal(tok, tok2, 13));
+
+	/* Too many unclosed arrays */
+	memset(deep, '[', sizeof(deep));
+	jsmn_init(&p);
+	check(jsmn_parse(&p, deep, sizeof(deep), many, 80) == JSMN_ERROR_PART);
+	check(jsmn_save(&p, many, &snap) == JSMN_ERROR_NOMEM);
+	return 0;
+}
+
+static int serialize(const char *js, const jsmn_edit *edits, int num_edits,
+		const char *expected) {
+	jsmn_parser p;
+	jsmntok_t tok[32];
+	jsmn_writer w;
+	char buf[128];
+	int r;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), tok, 32);
+	if (r < 0) {
+		return 0;
+	}
+	jsmn_writer_init(&w, buf, sizeof(buf));
+	r = jsmn_serialize(&w, js, strlen(js), tok, r, edits, num_edits);
+	if (r < 0 || r >= (int) sizeof(buf)) {
+		return 0;
+	}
+	if (strlen(expected) != (size_t) r || strncmp(buf, expected, r) != 0) {
+		printf("output is %.*s, not %s\n", r, buf, expected);
+		return 0;
+	}
+	return 1;
+}
+
+/* Every byte against the classes it should have */
+int test_char_classes(void) {
+	jsmn_parser p;
+	jsmntok_t t[4];
+	char js[16];
+	int c, strict, r;
+
+	for (c = 1; c < 256; c++) {
+		int hex = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+			(c >= 'A' && c <= 'F');
+		int ctrl = (c < 32 && c != '\t' && c != '\r' && c != '\n') || c >= 127;
+
+		/* \u escapes take hex digits only */
+		memcpy(js, "\"\\u0000\"", 9);
+		js[4] = (char) c;
+		jsmn_init(&p);
+		r = jsmn_parse(&p, js, 8, t, 4);
+		check(hex ? r == 1 && t[0].end == 7 : r == JSMN_ERROR_INVAL);
+
+		/* Strings take any other byte as it is */
+		if (c != '"' && c != '\\') {
+			memcpy(js, "\"a_b\"", 5);
+			js[2] = (char) c;
+			jsmn_init(&p);
+			r = jsmn_parse(&p, js, 5, t, 4);
+			check(r == 1 && t[0].start == 1 && t[0].end == 4);
+		}
+
+		/* Primitives reject control and non-ASCII bytes */
+		for (strict = 0; strict < 2; strict++) {
+			memcpy(js, "[1_]", 4);
+			js[2] = (char) c;
+			jsmn_init(&p);
+			p.strict = strict;
+			r = jsmn_parse(&p, js, 4, t, 4);
+			if (ctrl) {
+				check(r == JSMN_ERROR_INVAL && p.errpos == 2);
+			} else if (strchr(" \t\r\n,", c) != NULL) {
+				check(r == 2 && t[1].end == 2);
+			} else if (c == ':') {
+				/* Ends a primitive in lenient mode only */
+				check(r == 2 && t[1].end == (strict ? 3 : 2));
+			}
+		}
+	}
+	return 0;
+}
+
+int test_writer(void) {
+	jsmn_writer w;
+	char buf[64];
+
+	jsmn_writer_init(&w, buf, sizeof(buf));
+	jsmn_write_raw(&w, "[", 1);
+	jsmn_write_string(&w, "a\"b\\c\n\x01", 7);
+	jsmn_write_raw(&w, ",", 1);
+	jsmn_write_int(&w, -1234567890123LL);
+	jsmn_write_raw(&w, ",", 1);
+	jsmn_write_double(&w, 12.5);
+	jsmn_write_raw(&w, ",", 1);
+	jsmn_write_double(&w, 0.1);
+	jsmn_write_raw(&w, ",", 1);
+	jsmn_write_double(&w, -3.0);
+	jsmn_write_raw(&w, ",", 1);
+	jsmn_write_double(&w, 1e300);
+	jsmn_write_raw(&w, "]", 1);
+	check(w.len == strlen("[\"a\\\"b\\\\c\\n\\u0001\",-1234567890123,12.5,0.1,-3,1e+300]"));
+	check(strncmp(buf, "[\"a\\\"b\\\\c\\n\\u0001\",-1234567890123,12.5,0.1,-3,1e+300]",
+				w.len) == 0);
+
+	/* The sign of zero is kept */
+	jsmn_writer_init(&w, buf, sizeof(buf));
+	jsmn_write_double(&w, -0.0);
+	jsmn_write_raw(&w, ",", 1);
+	jsmn_write_double(&w, 0.0);
+	check(w.len == 4 && strncmp(buf, "-0,0", 4) == 0);
+
+	/* The decimal point does not follow the locale, if one is installed */
+	if (setlocale(LC_NUMERIC, "de_DE.UTF-8") != NULL ||
+			setlocale(LC_NUMERIC, "fr_FR.UTF-8") != NULL) {
+		jsmn_writer_init(&w, buf, sizeof(buf));
+		jsmn_write_double(&w, 0.1 + 0.2);
+		setlocale(LC_NUMERIC, "C");
+		check(w.len == 19 && strncmp(buf, "0.30000000000000004", 19) == 0);
+	}
+
+	/* Output is truncated, but the needed size is still counted */
+	jsmn_writer_init(&w, buf, 4);
+	jsmn_write_string(&w, "hello", 5);
+	check(w.len == 7 && strncmp(buf, "\"hel", 4) == 0);
+	return 0;
+}
+
+int test_serialize(void) {
+	const char *js = "{\"a\": 1, \"b\": [1, 2, 3], \"c\": \"x\"}";
+	jsmn_edit edits[5];
+
+	memset(edits, 0, sizeof(edits));
+	check(serialize(js, NULL, 0, js));
+
+	edits[0].op = JSMN_EDIT_INSERT;
+	edits[0].token = 0;
+	edits[0].key = "\"e\"";
+	edits[0].keylen = 3;
+	edits[0].value = "true";
+	edits[0].valuelen = 4;
+	edits[1].op = JSMN_EDIT_REPLACE;
+	edits[1].token = 2;
+	edits[1].value = "42";
+	edits[1].valuelen = 2;
+	edits[2].op = JSMN_EDIT_INSERT;
+	edits[2].token = 4;
+	edits[2].value = "4";
+	edits[2].valuelen = 1;
+	edits[3].op = JSMN_EDIT_DELETE;
+	edits[3].token = 6;
+	edits[4].op = JSMN_EDIT_REPLACE;
+	edits[4].token = 8;
+	edits[4].value = "\"d\"";
+	edits[4].valuelen = 3;
+	check(serialize(js, edits, 5,
+				"{\"a\": 42, \"b\": [1, 3,4], \"d\": \"x\",\"e\":true}"));
+
+	/* Edits must be sorted */
+	edits[0] = edits[3];
+	check(!serialize(js, edits, 2, js));
+
+	memset(edits, 0, sizeof(edits));
+	edits[0].op = JSMN_EDIT_DELETE;
+	edits[0].token = 1;
+	check(serialize("[1, 2, 3]", edits, 1, "[2, 3]"));
+	edits[0].token = 3;
+	check(serialize("[1, 2, 3]", edits, 1, "[1, 2]"));
+	edits[0].token = 2;
+	edits[1].op = JSMN_EDIT_DELETE;
+	edits[1].token = 3;
+	check(serialize("[1, 2, 3]", edits, 2, "[1]"));
+	edits[0].token = 1;
+	edits[1].token = 2;
+	edits[2].op = JSMN_EDIT_DELETE;
+	edits[2].token = 3;
+	check(serialize("[1, 2, 3]", edits, 3, "[]"));
+	edits[0].token = 4;
+	check(serialize("{\"a\": 1, \"b\": {\"c\": 2}}", edits, 1, "{\"a\": 1}"));
+	edits[0].token = 1;
+	check(serialize("{\"a\": 1, \"b\": {\"c\": 2}}", edits, 1, "{\"b\": {\"c\": 2}}"));
+	return 0;
+}
+
+int test_tape(void) {
+	jsmn_parser p;
+	jsmntok_t tok[16], cached[16];
+	const jsmntok_t *t;
+	unsigned int tape[64];
+	jsmn_intern_slot slots[4];
+	char names[16];
+	jsmn_intern in;
+	int ids[16];
+	jsmn_keyset keys;
+	const char *kept = "a";
+	char js[64];
+	int r, n;
+
+	check(jsmn_keyset_init(&keys, &kept, 1) == 0);
+
+	strcpy(js, "{\"a\": [1, 2, {\"b\": null}], \"c\": \"d\"}");
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	check(r == 10);
+	check(jsmn_tape_write(tape, 16, &p, js, strlen(js), tok, r) == JSMN_ERROR_NOMEM);
+	n = jsmn_tape_write(tape, sizeof(tape), &p, js, strlen(js), tok, r);
+	check(n == (int) jsmn_tape_size(r));
+
+	check(jsmn_tape_load(tape, n, &p, js, strlen(js), &t) == r);
+	check(memcmp(t, tok, r * sizeof(jsmntok_t)) == 0);
+	check(jsmn_tape_load(tape, n - 1, &p, js, strlen(js), &t) == JSMN_ERROR_INVAL);
+
+	jsmn_init(&p);
+	check(jsmn_parse_cached(&p, js, strlen(js), NULL, 0, tape, n) == r);
+	/* A counting hit leaves the parser where jsmn_parse() would */
+	check(p.toknext == 0 && p.pos == strlen(js));
+	jsmn_init(&p);
+	memset(cached, 0, sizeof(cached));
+	check(jsmn_parse_cached(&p, js, strlen(js), cached, 16, tape, n) == r);
+	check(memcmp(cached, tok, r * sizeof(jsmntok_t)) == 0);
+	check(p.toknext == (unsigned int) r && p.pos == strlen(js));
+
+	/* Same length, other content: the tape is stale and js is parsed */
+	js[7] = '7';
+	check(jsmn_tape_load(tape, n, &p, js, strlen(js), &t) == JSMN_ERROR_INVAL);
+	jsmn_init(&p);
+	check(jsmn_parse_cached(&p, js, strlen(js), cached, 16, tape, n) == r);
+	check(tokeq(js, cached, 4,
+				JSMN_OBJECT, -1, -1, 2,
+				JSMN_STRING, "a", 1,
+				JSMN_ARRAY, -1, -1, 3,
+				JSMN_PRIMITIVE, "7"));
+
+	/* A tape is not used by a parser in the other mode, with keys or
+	 * intern the input is always parsed */
+	js[7] = '1';
+	jsmn_init(&p);
+	p.strict = !p.strict;
+	check(jsmn_tape_load(tape, n, &p, js, strlen(js), &t) == JSMN_ERROR_INVAL);
+	strcpy(js, "{\"k\": x}");
+	jsmn_init(&p);
+	p.strict = 0;
+	r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	check(r == 3);
+	n = jsmn_tape_write(tape, sizeof(tape), &p, js, strlen(js), tok, r);
+	check(n > 0);
+	jsmn_init(&p);
+	p.strict = 1;
+	check(jsmn_parse_cached(&p, js, strlen(js), cached, 16, tape, n) ==
+			JSMN_ERROR_INVAL);
+	jsmn_init(&p);
+	p.strict = 0;
+	check(jsmn_parse_cached(&p, js, strlen(js), cached, 16, tape, n) == 3);
+	jsmn_intern_init(&in, slots, 4, names, sizeof(names));
+	in.ids = ids;
+	ids[1] = -1;
+	jsmn_init(&p);
+	p.strict = 0;
+	p.intern = &in;
+	check(jsmn_parse_cached(&p, js, strlen(js), cached, 16, tape, n) == 3);
+	check(ids[1] == 0);
+	p.intern = NULL;
+	p.keys = &keys;
+	check(jsmn_tape_write(tape, sizeof(tape), &p, js, strlen(js), tok, r) ==
+			JSMN_ERROR_INVAL);
+
+	/* Damaged tokens are never handed out */
+	strcpy(js, "{\"a\": [1, 2, {\"b\": null}], \"c\": \"d\"}");
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	n = jsmn_tape_write(tape, sizeof(tape), &p, js, strlen(js), tok, r);
+	check(jsmn_tape_load(tape, n, &p, js, strlen(js), &t) == r);
+	((jsmntok_t *) ((jsmn_tape *) tape + 1))[3].end = 1000;
+	check(jsmn_tape_load(tape, n, &p, js, strlen(js), &t) == JSMN_ERROR_INVAL);
+	((jsmntok_t *) ((jsmn_tape *) tape + 1))[3].end = tok[3].end;
+	((jsmntok_t *) ((jsmn_tape *) tape + 1))[7].size = 3;
+	check(jsmn_tape_load(tape, n, &p, js, strlen(js), &t) == JSMN_ERROR_INVAL);
+	return 0;
+}
+
+/* Reparses the edit of js into edited and compares with a full parse */
+static int reparse(const char *js, const char *edited) {
+	jsmn_parser p;
+	jsmntok_t tok[32], full[32];
+	unsigned int start, oldend, newend;
+	int r, n;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), tok, 32);
+	if (r < 0) {
+		return 0;
+	}
+	for (start = 0; js[start] != '\0' && js[start] == edited[start]; start++);
+	oldend = strlen(js);
+	newend = strlen(edited);
+	while (oldend > start && newend > start &&
+			js[oldend - 1] == edited[newend - 1]) {
+		oldend--;
+		newend--;
+	}
+	n = jsmn_reparse(&p, edited, strlen(edited), tok, 32, r,
+			start, oldend, newend);
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, edited, strlen(edited), full, 32);
+	if (n != r) {
+		printf("reparse returned %d, not %d\n", n, r);
+		return 0;
+	}
+	return r < 0 || tokens_equal(tok, full, r);
+}
+
+int test_reparse(void) {
+	const char *js = "{\"a\": [1, 2, {\"b\": null}], \"c\": \"d\"}";
+	const char *edited;
+	jsmn_intern_slot slots[8];
+	char names[16];
+	jsmn_intern in;
+	jsmn_parser p;
+	jsmntok_t tok[16];
+	int ids[16];
+	int r;
+
+	check(reparse(js, "{\"a\": [1, 2, {\"b\": true}], \"c\": \"d\"}"));
+	check(reparse(js, "{\"a\": [1, [3, 4], {\"b\": null}], \"c\": \"d\"}"));
+	check(reparse(js, "{\"a\": [1, {\"b\": null}], \"c\": \"d\"}"));
+	check(reparse(js, "{\"a\": [1, 2, {}], \"c\": \"d\"}"));
+	check(reparse(js, "{\"a\": [1, 2, {\"b\": null, \"e\": [[]]}], \"c\": \"d\"}"));
+	check(reparse(js, "{\"a\": [1, 2, {\"b\": null}], \"c\": \"d\", \"e\": 5}"));
+	check(reparse(js, "{\"a\": [1, 2, {\"b\": null}], \"c\": [\"d\"]}"));
+	/* Edits touching brackets, and edits that break the container */
+	check(reparse(js, "[1, 2, {\"b\": null}]"));
+	check(reparse(js, "{\"a\": [1, 2, {\"b\": null}, \"c\": \"d\"}"));
+	check(reparse(js, "{\"a\": [1, 2, {\"b\": null}], \"c\": \"d\"} [3]"));
+	check(reparse(js, "{\"a\": [1, 2, {\"b\": null]], \"c\": \"d\"}"));
+	check(reparse(js, "{\"a\": [1, 2\", {\"b\": null}], \"c\": \"d\"}"));
+	check(reparse(js, "{\"a\": [1, 2], [3]}"));
+
+	/* Tokens outside of the edited container are not rewritten */
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	check(r == 10);
+	tok[1].size = 7;
+	check(jsmn_reparse(&p, "{\"a\": [1, 2, {\"b\": 12}], \"c\": \"d\"}",
+				strlen(js) - 2, tok, 16, r, 19, 23, 21) == r);
+	check(tok[1].size == 7);
+	check(tok[0].end == (int) strlen(js) - 2 && tok[9].start == 31);
+
+	/* Key ids move with their tokens */
+	jsmn_intern_init(&in, slots, 8, names, sizeof(names));
+	in.ids = ids;
+	memset(ids, 0xff, sizeof(ids));
+	jsmn_init(&p);
+	p.intern = &in;
+	r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	check(r == 10 && ids[1] == 0 && ids[6] == 1 && ids[8] == 2);
+	edited = "{\"a\": [1, [3, 4], {\"b\": null}], \"c\": \"d\"}";
+	check(jsmn_reparse(&p, edited, strlen(edited), tok, 16, r, 10, 11, 16) ==
+			12);
+	check(tokeq(edited, tok + 8, 1, JSMN_STRING, "b", 1) &&
+			tokeq(edited, tok + 10, 1, JSMN_STRING, "c", 1));
+	check(ids[1] == 0 && ids[8] == 1 && ids[10] == 2);
+	return 0;
+}
+
+struct bind_addr {
+	char city[8];
+	int zip;
+};
+
+struct bind_user {
+	char name[16];
+	int admin;
+	int uid;
+	long long id;
+	double score;
+	struct bind_addr addr;
+};
+
+static jsmn_schema bind_addr_schema;
+
+static const jsmn_field bind_addr_fields[] = {
+	JSMN_FIELD(struct bind_addr, city, "city", JSMN_BIND_STRING),
+	JSMN_FIELD(struct bind_addr, zip, "zip", JSMN_BIND_INT),
+};
+
+static const jsmn_field bind_user_fields[] = {
+	JSMN_FIELD(struct bind_user, name, "name", JSMN_BIND_STRING),
+	JSMN_FIELD(struct bind_user, admin, "admin", JSMN_BIND_BOOL),
+	JSMN_FIELD(struct bind_user, uid, "uid", JSMN_BIND_INT),
+	JSMN_FIELD(struct bind_user, id, "id", JSMN_BIND_LONG),
+	JSMN_FIELD(struct bind_user, score, "score", JSMN_BIND_DOUBLE),
+	JSMN_FIELD_OBJECT(struct bind_user, addr, "addr", &bind_addr_schema),
+};
+
+static int bind(const char *js, const jsmn_schema *schema,
+		struct bind_user *u) {
+	jsmn_parser p;
+	jsmntok_t tok[32];
+	int r;
+
+	jsmn_init(&p);
+	r = jsmn_parse(&p, js, strlen(js), tok, 32);
+	if (r < 0) {
+		return r;
+	}
+	memset(u, 0, sizeof(*u));
+	return jsmn_bind(js, tok, r, schema, u);
+}
+
+int test_bind(void) {
+	jsmn_schema schema;
+	struct bind_user u;
+	int r;
+
+	check(jsmn_schema_init(&bind_addr_schema, bind_addr_fields, 2) == 0);
+	check(jsmn_schema_init(&schema, bind_user_fields, 6) == 0);
+	check(jsmn_schema_find(&schema, "uid", 3) == 2);
+	check(jsmn_schema_find(&schema, "score", 5) == 4);
+	check(jsmn_schema_find(&schema, "scor", 4) == -1);
+	check(jsmn_schema_find(&schema, "", 0) == -1);
+
+	check(bind("{\"id\": -9223372036854775808, \"name\": \"a\\\"b\\u00e9\","
+				"\"tags\": [1, {\"uid\": 5}], \"uid\": 1000, \"admin\": true,"
+				"\"addr\": {\"zip\": 12345, \"city\": \"Oslo\", \"x\": {}},"
+				"\"score\": 2.5e-1}", &schema, &u) == 7);
+	check(u.id == LLONG_MIN && u.uid == 1000 && u.admin == 1);
+	check(strcmp(u.name, "a\"b\xc3\xa9") == 0);
+	check(u.score == 0.25);
+	check(strcmp(u.addr.city, "Oslo") == 0 && u.addr.zip == 12345);
+
+	/* null is skipped, missing members keep their values */
+	check(bind("{\"uid\": null, \"name\": \"\\ud83d\\ude00\"}", &schema, &u) == 1);
+	check(u.uid == 0 && strcmp(u.name, "\xf0\x9f\x98\x80") == 0);
+
+	check(bind("{\"uid\": 2147483648}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"uid\": 1.5}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"uid\": 007}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"uid\": -01}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"uid\": -0, \"id\": 0}", &schema, &u) == 2 &&
+			u.uid == 0 && u.id == 0);
+	check(bind("{\"uid\": \"1\"}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"admin\": 1}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"addr\": [1]}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"name\": \"0123456789abcdef\"}", &schema, &u) ==
+			JSMN_ERROR_NOMEM);
+	check(bind("[1]", &schema, &u) == JSMN_ERROR_INVAL);
+
+	/* Only JSON numbers, whatever else strtod() reads */
+	check(bind("{\"score\": 1e5}", &schema, &u) == 1 && u.score == 100000);
+	check(bind("{\"score\": -0.5E+1}", &schema, &u) == 1 && u.score == -5);
+	check(bind("{\"score\": 0x10}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"score\": inf}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"score\": 01}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"score\": 1.}", &schema, &u) == JSMN_ERROR_INVAL);
+	check(bind("{\"score\": 1e}", &schema, &u) == JSMN_ERROR_INVAL);
+
+	/* The decimal point does not follow the locale, if one is installed */
+	if (setlocale(LC_NUMERIC, "de_DE.UTF-8") != NULL ||
+			setlocale(LC_NUMERIC, "fr_FR.UTF-8") != NULL) {
+		r = bind("{\"score\": 1.5}", &schema, &u);
+		setlocale(LC_NUMERIC, "C");
+		check(r == 1 && u.score == 1.5);
+	}
+	return 0;
+}
+
+int test_keyset(void) {
+	const char *names[] = { "id", "geo", "lat" };
+	const char *dup[] = { "id", "id" };
+	const char *js = "{\"id\": 7, \"name\": \"x\\\"}\", \"tags\": [1, [{}], \"]\"],"
+		" \"geo\": {\"lat\": -1.5, \"lon\": 2}, \"more\": {\"id\": 8}, \"z\": true}";
+	jsmn_keyset set;
+	jsmn_parser p;
+	jsmntok_t tok[16];
+	int r;
+
+	check(jsmn_keyset_init(&set, dup, 2) == JSMN_ERROR_INVAL);
+	check(jsmn_keyset_init(&set, names, 3) == 0);
+	check(set.lengths[0] == 2 && set.lengths[1] == 3 && set.lengths[2] == 3);
+	check(strcmp(set.names[1], "geo") == 0);
+
+	jsmn_init(&p);
+	p.keys = &set;
+	r = jsmn_parse(&p, js, strlen(js), NULL, 0);
+	check(r == 7);
+	jsmn_init(&p);
+	p.keys = &set;
+	r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	check(r == 7);
+	check(tokeq(js, tok, 7,
+				JSMN_OBJECT, 0, (int) strlen(js), 2,
+				JSMN_STRING, "id", 1,
+				JSMN_PRIMITIVE, "7",
+				JSMN_STRING, "geo", 1,
+				JSMN_OBJECT, 57, 80, 1,
+				JSMN_STRING, "lat", 1,
+				JSMN_PRIMITIVE, "-1.5"));
+
+	/* Unknown values are not tokenized, so they need no token space */
+	jsmn_init(&p);
+	p.keys = &set;
+	check(jsmn_parse(&p, "{\"a\": [1, 2, 3, 4, 5, 6, 7, 8]}", 32, tok, 1) == 1);
+	check(tok[0].size == 0);
+
+	/* Skipped values still have to be complete */
+	jsmn_init(&p);
+	p.keys = &set;
+	check(jsmn_parse(&p, "{\"a\": [1, \"]", 12, tok, 16) == JSMN_ERROR_PART);
+	check(p.pos == 1 && p.toknext == 1);
+	jsmn_init(&p);
+	p.keys = &set;
+	check(jsmn_parse(&p, "{\"a\": }", 7, tok, 16) == JSMN_ERROR_INVAL);
+	check(p.errpos == 6);
+	return 0;
+}
+
+int test_intern(void) {
+	const char *js1 = "{\"id\": 1, \"n\\u0061me\": \"x\", \"geo\": {\"id\": 2}}";
+	const char *js2 = "[{\"geo\": null, \"id\": 3, \"new\": [\"id\"]}]";
+	jsmn_intern_slot slots[8];
+	char names[24];
+	jsmn_intern in;
+	jsmn_parser p;
+	jsmntok_t tok[16];
+	int ids[16];
+	int r;
+
+	jsmn_intern_init(&in, slots, 8, names, sizeof(names));
+	check(jsmn_intern_key(&in, "id", 2) == 0);
+	in.ids = ids;
+
+	memset(ids, 0xff, sizeof(ids));
+	jsmn_init(&p);
+	p.intern = &in;
+	r = jsmn_parse(&p, js1, strlen(js1), tok, 16);
+	check(r == 9);
+	check(ids[1] == 0 && ids[3] == 1 && ids[5] == 2 && ids[7] == 0);
+	check(in.num_ids == 3);
+	check(jsmn_intern_key(&in, "n\\u0061me", 9) == 1);
+
+	/* Ids stay the same for the next documents */
+	jsmn_init(&p);
+	p.intern = &in;
+	r = jsmn_parse(&p, js2, strlen(js2), tok, 16);
+	check(r == 9);
+	check(ids[2] == 2 && ids[4] == 0 && ids[6] == 3 && ids[8] == -1);
+
+	/* A key split between two calls is hashed when its colon arrives */
+	jsmn_init(&p);
+	p.intern = &in;
+	check(jsmn_parse(&p, js2, 8, tok, 16) == JSMN_ERROR_PART);
+	check(jsmn_parse(&p, js2, strlen(js2), tok, 16) == 9);
+	check(ids[2] == 2);
+
+	/* Only 6 of 8 slots are used, names that do not fit get -1 */
+	check(jsmn_intern_key(&in, "a", 1) == 4);
+	check(jsmn_intern_key(&in, "b", 1) == 5);
+	check(jsmn_intern_key(&in, "c", 1) == -1);
+	check(jsmn_intern_key(&in, "id", 2) == 0);
+
+	/* Tables too small to keep a slot empty are refused, not probed forever */
+	check(jsmn_intern_init(&in, slots, 2, names, sizeof(names)) ==
+			JSMN_ERROR_INVAL);
+	check(jsmn_intern_key(&in, "id", 2) == -1);
+	check(jsmn_intern_init(&in, slots, 6, names, sizeof(names)) ==
+			JSMN_ERROR_INVAL);
+	check(jsmn_intern_init(&in, slots, 4, names, sizeof(names)) == 0);
+	check(jsmn_intern_key(&in, "a", 1) == 0);
+	check(jsmn_intern_key(&in, "b", 1) == 1);
+	check(jsmn_intern_key(&in, "c", 1) == 2);
+	check(jsmn_intern_key(&in, "d", 1) == -1);
+	check(jsmn_intern_key(&in, "e", 1) == -1);
+	in.ids = ids;
+	memset(ids, 0, sizeof(ids));
+	jsmn_init(&p);
+	p.intern = &in;
+	check(jsmn_parse(&p, js1, strlen(js1), tok, 16) == 9);
+	check(ids[1] == -1 && ids[3] == -1 && ids[7] == -1);
+
+	/* Works together with skipping of unknown members */
+	jsmn_intern_init(&in, slots, 8, names, sizeof(names));
+	in.ids = ids;
+	jsmn_init(&p);
+	p.intern = &in;
+	p.keys = NULL;
+	{
+		const char *keep[] = { "geo", "id" };
+		jsmn_keyset set;
+		check(jsmn_keyset_init(&set, keep, 2) == 0);
+		p.keys = &set;
+		r = jsmn_parse(&p, js1, strlen(js1), tok, 16);
+	}
+	check(r == 7);
+	check(ids[1] == 0 && ids[3] == 1 && ids[5] == 0 && in.num_ids == 2);
+
+	/* A skipped member between a key and a stray colon (lenient input)
+	 * leaves the hash of its name behind, which is not the key's */
+	jsmn_intern_init(&in, slots, 8, names, sizeof(names));
+	in.ids = ids;
+	jsmn_init(&p);
+	p.strict = 0;
+	p.intern = &in;
+	{
+		const char *js = "{\"a\" \"zz\": 1 : 2, \"a\": 3}";
+		const char *keep[] = { "a" };
+		jsmn_keyset set;
+		check(jsmn_keyset_init(&set, keep, 1) == 0);
+		p.keys = &set;
+		r = jsmn_parse(&p, js, strlen(js), tok, 16);
+	}
+	check(r == 5);
+	check(ids[1] == 0 && ids[3] == 0 && in.num_ids == 1);
+	return 0;
+}
+
+int test_pool(void) {
+	jsmn_parser p;
+	jsmn_ctx *ctx, *other;
+	char js[1024];
+	unsigned int i;
+	int n = 0;
+
+	js[n++] = '[';
+	for (i = 0; i < 200; i++) {
+		n += sprintf(js + n, "%s%u", i > 0 ? "," : "", i % 10);
+	}
+	js[n++] = ']';
+	js[n] = '\0';
+
+	ctx = jsmn_ctx_get();
+	check(ctx != NULL);
+	ctx->parser.strict = 1;
+	check(jsmn_ctx_parse(ctx, js, n) == 201);
+	check(ctx->num_tokens == 4 * JSMN_POOL_MIN && ctx->high == 201);
+	check(tokeq(js, ctx->tokens, 2,
+				JSMN_ARRAY, 0, n, 200,
+				JSMN_PRIMITIVE, "0"));
+	check(jsmn_ctx_parse(ctx, "[x]", 3) == JSMN_ERROR_INVAL);
+	check(jsmn_ctx_parse(ctx, "[1]", 3) == 2);
+
+	/* Contexts are recycled with their tokens, most recent first */
+	other = jsmn_ctx_get();
+	check(other != ctx);
+	jsmn_ctx_put(other);
+	jsmn_ctx_put(ctx);
+	check(jsmn_ctx_get() == ctx);
+	jsmn_init(&p);
+	check(ctx->num_tokens == 4 * JSMN_POOL_MIN &&
+			ctx->parser.strict == p.strict);
+	check(jsmn_ctx_get() == other);
+
+	/* The period with the large document keeps the array, a period of
+	 * small documents only shrinks it */
+	for (i = 1; i < JSMN_POOL_TRIM_INTERVAL; i++) {
+		check(jsmn_ctx_parse(ctx, "[1, 2]", 6) == 3);
+		jsmn_ctx_put(ctx);
+		check(jsmn_ctx_get() == ctx);
+	}
+	check(ctx->num_tokens == 4 * JSMN_POOL_MIN);
+	for (i = 1; i < JSMN_POOL_TRIM_INTERVAL; i++) {
+		check(jsmn_ctx_parse(ctx, "[1, 2]", 6) == 3);
+		jsmn_ctx_put(ctx);
+		check(jsmn_ctx_get() == ctx);
+	}
+	check(ctx->num_tokens == 4 * JSMN_POOL_MIN);
+	jsmn_ctx_put(ctx);
+	check(ctx->num_tokens == JSMN_POOL_MIN);
+
+	jsmn_ctx_put(other);
+	jsmn_pool_trim();
+	return 0;
+}
+
+int test_soa(void) {
+	const char *js = "{\"a\": [1, \"x\", [true, \"y\"]], \"b\": {\"c\": null}, "
+		"\"d\": \"z\"}";
+	unsigned char type[16];
+	jsmnint_t start[16], end[16], size[16], parent[16];
+	jsmnint_t starts[16], ends[16];
+	jsmn_soa soa;
+	jsmn_parser p;
+	jsmntok_t t[16];
+	int i, n;
+
+	soa.type = type;
+	soa.start = start;
+	soa.end = end;
+	soa.size = size;
+	soa.parent = parent;
+
+	jsmn_init(&p);
+	n = jsmn_parse(&p, js, strlen(js), t, 16);
+	check(n == 14);
+	jsmn_init(&p);
+	check(jsmn_parse_soa(&p, js, strlen(js), &soa, 16) == n);
+	for (i = 0; i < n; i++) {
+		check(type[i] == t[i].type && start[i] == t[i].start &&
+				end[i] == t[i].end && size[i] == t[i].size);
+#ifdef JSMN_PARENT_LINKS
+		check(parent[i] == t[i].parent);
+#endif
+	}
+	check(parent[0] == -1 && parent[1] == 0 && parent[2] == 1 &&
+			parent[5] == 2 && parent[12] == 0 && parent[13] == 12);
+
+	/* Columns under "a": [1, "x", [true, "y"]] */
+	check(jsmn_soa_skip(&soa, n, 2) == 8);
+	check(jsmn_soa_skip(&soa, n, 1) == 8);
+	check(jsmn_soa_skip(&soa, n, 0) == 14);
+	check(jsmn_soa_skip(&soa, n, 12) == 14);
+	check(jsmn_soa_count(&soa, 3, 8, JSMN_PRIMITIVE) == 2);
+	check(jsmn_soa_count(&soa, 0, n, JSMN_STRING) == 7);
+	check(jsmn_soa_gather(&soa, 3, 8, JSMN_STRING, starts, ends) == 2);
+	check(strncmp(js + starts[0], "x", ends[0] - starts[0]) == 0);
+	check(strncmp(js + starts[1], "y", ends[1] - starts[1]) == 0);
+
+	/* Same errors as jsmn_parse() */
+	jsmn_init(&p);
+	check(jsmn_parse_soa(&p, js, strlen(js), &soa, 4) == JSMN_ERROR_NOMEM);
+	jsmn_init(&p);
+	check(jsmn_parse_soa(&p, js, 20, &soa, 16) == JSMN_ERROR_PART);
+	return 0;
+}
+
+int test_columns(void) {
+	const char *js =
+		"{\"id\": 1, \"geo\": {\"lat\": 52.5, \"name\": \"Ber\\u006cin\"}}\n"
+		"{\"skip\": [\"}\", {\"id\": 9}], \"id\": -9223372036854775808,"
+		" \"geo\": {\"lat\": null}}\n"
+		"\n"
+		"{\"geo\": {\"name\": \"x\", \"lat\": 1e-3, \"name\": \"\"}, \"id\": null}\n";
+	const char *nums[] = { "0", "-0.0", "0.1", "123.456e-7", "1e22", "1e23",
+		"9007199254740993", "12345678901234567890", "2.2250738585072014e-308",
+		"4.9e-324", "1.7976931348623157e308", "0.000000000000000000001" };
+	jsmn_column cols[3];
+	jsmn_columns loader;
+	char line[64];
+	unsigned int i;
+
+	cols[0].path = "id";
+	cols[0].type = JSMN_COLUMN_INT64;
+	cols[1].path = "geo.lat";
+	cols[1].type = JSMN_COLUMN_DOUBLE;
+	cols[2].path = "geo.name";
+	cols[2].type = JSMN_COLUMN_STRING;
+	check(jsmn_columns_init(&loader, cols, 3) == 0);
+	check(jsmn_columns_load(&loader, js, strlen(js)) == 3);
+	check(loader.num_rows == 3);
+
+	check(jsmn_column_valid(&cols[0], 0) && cols[0].ints[0] == 1);
+	check(jsmn_column_valid(&cols[0], 1) && cols[0].ints[1] == LLONG_MIN);
+	check(!jsmn_column_valid(&cols[0], 2) && cols[0].ints[2] == 0);
+	check(jsmn_column_valid(&cols[1], 0) && cols[1].doubles[0] == 52.5);
+	check(!jsmn_column_valid(&cols[1], 1));
+	check(jsmn_column_valid(&cols[1], 2) && cols[1].doubles[2] == 1e-3);
+	check(cols[2].offsets[1] == 6 && memcmp(cols[2].chars, "Berlin", 6) == 0);
+	check(!jsmn_column_valid(&cols[2], 1) && cols[2].offsets[2] == 6);
+	/* Last duplicate wins */
+	check(jsmn_column_valid(&cols[2], 2) && cols[2].offsets[3] == 6);
+
+	/* Type mismatches and malformed records, earlier rows are kept */
+	js = "{\"id\": 2}\n{\"id\": 1.5}\n";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	check(loader.num_rows == 4 && loader.errpos == 17);
+	js = "{\"id\": \"2\"}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	js = "{\"id\": 9223372036854775808}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	js = "{\"geo\": {\"lat\": [1]}}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	js = "{\"id\" 1}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	js = "[1]";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	/* Both number types read the same grammar */
+	js = "{\"id\": 01}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	js = "{\"geo\": {\"lat\": 01}}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	js = "{\"geo\": {\"lat\": -.5}}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	js = "{\"geo\": {\"lat\": 1.e5}}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	js = "{\"id\": 1e5}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_INVAL);
+	check(loader.num_rows == 4);
+
+	/* Incomplete last record, loaded again from errpos */
+	js = "{\"id\": 5}\n{\"id\": 6, \"geo\": {\"name\": \"ab";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == JSMN_ERROR_PART);
+	check(loader.num_rows == 5 && loader.errpos == 10);
+	js = "{\"id\": 6, \"geo\": {\"name\": \"abc\"}}";
+	check(jsmn_columns_load(&loader, js, strlen(js)) == 1);
+	check(cols[0].ints[5] == 6 && cols[2].offsets[6] - cols[2].offsets[5] == 3);
+
+	/* Fast double conversion agrees with strtod() */
+	for (i = 0; i < sizeof(nums) / sizeof(nums[0]); i++) {
+		double d = strtod(nums[i], NULL);
+		sprintf(line, "{\"geo\": {\"lat\": %s}}", nums[i]);
+		check(jsmn_columns_load(&loader, line, strlen(line)) == 1);
+		check(memcmp(&cols[1].doubles[loader.num_rows - 1], &d,
+					sizeof(d)) == 0);
+	}
+
+	/* Columns grow */
+	for (i = 0; i < 200; i++) {
+		sprintf(line, "{\"id\": %u}", i);
+		check(jsmn_columns_load(&loader, line, strlen(line)) == 1);
+	}
+	check(cols[0].ints[loader.num_rows - 1] == 199);
+	check(jsmn_column_valid(&cols[0], loader.num_rows - 1));
+	check(!jsmn_column_valid(&cols[1], loader.num_rows - 1));
+	jsmn_columns_free(&loader);
+
+	/* Paths */
+	cols[1].path = "id.x";
+	check(jsmn_columns_init(&loader, cols, 2) == JSMN_ERROR_INVAL);
+	cols[1].path = "geo..lat";
+	check(jsmn_columns_init(&loader, cols, 2) == JSMN_ERROR_INVAL);
+	cols[1].path = "a.b.c.d.e.f.g.h.i";
+	check(jsmn_columns_init(&loader, cols, 2) == JSMN_ERROR_NOMEM);
+	return 0;
+}
+
+int test_canon(void) {
+	const char *js = "{ \"b\" : [ 1.0, 1e2, -0, 12.340e-1, 1e21, 0.0000015 ],\n"
+		"\t\"a \\u00e9\" : \"x\\/y\\u0041\\n\\u001F\\ud83d\\ude00\\udc00\",\n"
+		"  \"a\" : { \"z\" : null, \"y\" : true }, \"\" : false }";
+	const char *canon = "{\"\":false,\"a\":{\"y\":true,\"z\":null},"
+		"\"a \xc3\xa9\":\"x/yA\\n\\u001f\xf0\x9f\x98\x80\\udc00\","
+		"\"b\":[1,100,0,1.234,1e+21,0.0000015]}";
+	char pretty[256], out[256];
+	jsmntok_t t[32], t2[32];
+	int scratch[32];
+	jsmn_writer w;
+	jsmn_parser p;
+	int n, r, i;
+
+	jsmn_init(&p);
+	n = jsmn_parse(&p, js, strlen(js), t, 32);
+	check(n == 19);
+
+	/* Whitespace inside strings stays */
+	jsmn_writer_init(&w, out, sizeof(out));
+	r = jsmn_minify(&w, js, t, n);
+	check(r > 0 && (size_t) r < strlen(js));
+	check(strncmp(out, "{\"b\":[1.0,1e2,-0,12.340e-1,1e21,0.0000015],"
+				"\"a \\u00e9\":", 46) == 0);
+	jsmn_init(&p);
+	check(jsmn_parse(&p, out, r, t2, 32) == n);
+
+	jsmn_writer_init(&w, out, sizeof(out));
+	r = jsmn_canonicalize(&w, js, t, n, scratch);
+	check(r == (int) strlen(canon) && memcmp(out, canon, r) == 0);
+
+	/* Canonical form is a fixed point, and does not depend on layout */
+	memcpy(pretty, out, r);
+	jsmn_init(&p);
+	n = jsmn_parse(&p, pretty, r, t, 32);
+	jsmn_writer_init(&w, out, sizeof(out));
+	check(jsmn_canonicalize(&w, pretty, t, n, scratch) == r);
+	check(memcmp(out, canon, r) == 0);
+
+	/* Long runs go through the vector kernel */
+	pretty[0] = '[';
+	for (i = 1; i < 100; i++) {
+		pretty[i] = " \n\t\r"[i % 4];
+	}
+	strcpy(pretty + 100, "\"a  b\" ,  1 ,\n\n   {  }   ,[\t] ]");
+	jsmn_init(&p);
+	n = jsmn_parse(&p, pretty, strlen(pretty), t, 32);
+	jsmn_writer_init(&w, out, sizeof(out));
+	r = jsmn_minify(&w, pretty, t, n);
+	check(r == 16 && memcmp(out, "[\"a  b\",1,{},[]]", 16) == 0);
+
+	/* Numbers equal in value are written the same */
+	js = "[0.1e1, 10e-1, 1, 120e-1, 1.2e1, 0.00001234e3, 1e-6, 1e-7,"
+		" 123456789012345678901234, -0.0e5]";
+	jsmn_init(&p);
+	n = jsmn_parse(&p, js, strlen(js), t, 32);
+	jsmn_writer_init(&w, out, sizeof(out));
+	r = jsmn_canonicalize(&w, js, t, n, scratch);
+	check(r > 0 && strncmp(out, "[1,1,1,12,12,0.01234,0.000001,1e-7,"
+				"1.23456789012345678901234e+23,0]", r) == 0);
+
+	/* Output that does not fit is counted */
+	jsmn_writer_init(&w, out, 4);
+	check(jsmn_canonicalize(&w, js, t, n, scratch) == r);
+
+	/* Lenient tokens that are not JSON */
+	js = "{a: 1}";
+	jsmn_init(&p);
+	p.strict = 0;
+	n = jsmn_parse(&p, js, strlen(js), t, 32);
+	check(n == 3);
+	jsmn_writer_init(&w, out, sizeof(out));
+	check(jsmn_canonicalize(&w, js, t, n, scratch) == JSMN_ERROR_INVAL);
+	return 0;
+}
+
+int test_diff(void) {
+	const char *old_js = "{\"port\": 80, \"hosts\": [\"a\", \"b\"], \"tls\": {\"on\": false},"
+		" \"name\": \"x\", \"log\": null}";
+	const char *new_js = "{\"port\":8080,\"hosts\":[\"a\",\"b\",\"c\"],\"tls\":[],"
+		"\"name\":\"x\",\"debug\":true}";
+	const char *moved = "{\"log\": null, \"name\": \"x\", \"tls\": {\"on\": false},"
+		"\n\"hosts\": [\"a\", \"b\"], \"port\": 80}";
+	jsmntok_t t1[32], t2[32];
+	jsmn_change changes[8];
+	int scratch[64];
+	jsmn_doc a, b;
+	jsmn_parser p;
+	int r;
+
+	jsmn_init(&p);
+	a.js = old_js;
+	a.tokens = t1;
+	a.num_tokens = jsmn_parse(&p, old_js, strlen(old_js), t1, 32);
+	check(a.num_tokens == 15);
+	jsmn_init(&p);
+	b.js = new_js;
+	b.tokens = t2;
+	b.num_tokens = jsmn_parse(&p, new_js, strlen(new_js), t2, 32);
+	check(b.num_tokens == 14);
+
+	/* Members by position */
+	r = jsmn_diff(&a, &b, 0, NULL, changes, 8);
+	check(r == 5);
+	check(changes[0].op == JSMN_DIFF_CHANGED && changes[0].a == 2 &&
+			changes[0].b == 2);
+	check(changes[1].op == JSMN_DIFF_ADDED && changes[1].a == -1 &&
+			tokeq(new_js, &t2[changes[1].b], 1, JSMN_STRING, "c", 0));
+	check(changes[2].op == JSMN_DIFF_CHANGED && t1[changes[2].a].type ==
+			JSMN_OBJECT && t2[changes[2].b].type == JSMN_ARRAY);
+	check(changes[3].op == JSMN_DIFF_REMOVED && changes[3].b == -1 &&
+			tokeq(old_js, &t1[changes[3].a - 1], 1, JSMN_STRING, "log", 1));
+	check(changes[4].op == JSMN_DIFF_ADDED &&
+			tokeq(new_js, &t2[changes[4].b - 1], 1, JSMN_STRING, "debug", 1));
+
+	/* By keys, in key order */
+	r = jsmn_diff(&a, &b, JSMN_DIFF_UNORDERED, scratch, changes, 8);
+	check(r == 5);
+	check(changes[0].op == JSMN_DIFF_ADDED &&
+			tokeq(new_js, &t2[changes[0].b - 1], 1, JSMN_STRING, "debug", 1));
+	check(changes[1].op == JSMN_DIFF_ADDED && changes[1].b == 7);
+	check(changes[2].op == JSMN_DIFF_REMOVED && changes[2].a == 14);
+	check(changes[3].op == JSMN_DIFF_CHANGED && changes[3].a == 2);
+	check(changes[4].op == JSMN_DIFF_CHANGED && changes[4].b == 9);
+
+	/* Only the first changes are stored, all are counted */
+	check(jsmn_diff(&a, &b, 0, NULL, changes, 1) == 5);
+	check(jsmn_diff(&b, &a, 0, NULL, changes, 8) == 5);
+	check(changes[3].op == JSMN_DIFF_REMOVED && changes[4].op == JSMN_DIFF_ADDED);
+	check(jsmn_equal(&a, &b, 0, NULL) == 0);
+	check(jsmn_equal(&a, &a, 0, NULL) == 1);
+
+	/* Layout does not matter, member order only without JSMN_DIFF_UNORDERED */
+	jsmn_init(&p);
+	b.js = moved;
+	b.num_tokens = jsmn_parse(&p, moved, strlen(moved), t2, 32);
+	check(b.num_tokens == 15);
+	check(jsmn_equal(&a, &b, 0, NULL) == 0);
+	check(jsmn_equal(&a, &b, JSMN_DIFF_UNORDERED, scratch) == 1);
+	check(jsmn_diff(&a, &b, JSMN_DIFF_UNORDERED, scratch, changes, 8) == 0);
+
+	/* Keys repeated within an object are matched in document order */
+	a.js = "{\"k\": 1, \"k\": 2}";
+	jsmn_init(&p);
+	a.num_tokens = jsmn_parse(&p, a.js, strlen(a.js), t1, 32);
+	b.js = "{\"k\":1,\"j\":0,\"k\":3}";
+	jsmn_init(&p);
+	b.num_tokens = jsmn_parse(&p, b.js, strlen(b.js), t2, 32);
+	r = jsmn_diff(&a, &b, JSMN_DIFF_UNORDERED, scratch, changes, 8);
+	check(r == 2);
+	check(changes[0].op == JSMN_DIFF_ADDED && changes[0].b == 4);
+	check(changes[1].op == JSMN_DIFF_CHANGED && changes[1].a == 4 &&
+			changes[1].b == 6);
+
+	/* Strings and numbers as written */
+	a.js = "[\"A\", 1.0]";
+	jsmn_init(&p);
+	a.num_tokens = jsmn_parse(&p, a.js, strlen(a.js), t1, 32);
+	b.js = "[\"\\u0041\", 1]";
+	jsmn_init(&p);
+	b.num_tokens = jsmn_parse(&p, b.js, strlen(b.js), t2, 32);
+	check(jsmn_diff(&a, &b, 0, NULL, changes, 8) == 2);
+
+	a.num_tokens = 0;
+	check(jsmn_diff(&a, &b, 0, NULL, changes, 8) == JSMN_ERROR_INVAL);
+	return 0;
+}
+
 int main(void) {
 	test(test_empty, "test for a empty JSON objects/arrays");
 	test(test_object, "test for a JSON objects");
@@ -402,6 +1563,23 @@ int main(void) {
 	test(test_count, "test tokens count estimation");
 	test(test_nonstrict, "test for non-strict mode");
 	test(test_unmatched_brackets, "test for unmatched brackets");
+	test(test_runtime_strict, "test strict mode selected at runtime");
+	test(test_error_location, "test error offset, line and column");
+	test(test_recover, "test skipping of broken records");
+	test(test_snapshot, "test saving and restoring parser state");
+	test(test_char_classes, "test character classes of all bytes");
+	test(test_writer, "test JSON writer");
+	test(test_serialize, "test serializing tokens with edits");
+	test(test_tape, "test token tapes");
+	test(test_reparse, "test incremental reparse after edits");
+	test(test_bind, "test decoding into structs");
+	test(test_keyset, "test skipping unknown object members");
+	test(test_intern, "test key interning");
+	test(test_pool, "test pooled parser contexts");
+	test(test_soa, "test tokens as a structure of arrays");
+	test(test_columns, "test loading records into columns");
+	test(test_canon, "test minifying and canonicalizing");
+	test(test_diff, "test comparing documents");
 	printf("\nPASSED: %d\nFAILED: %d\n", test_passed, test_failed);
 	return (test_failed > 0);
 }
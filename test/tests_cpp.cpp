@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+
+#define JSMN_STATIC
+#include "../jsmn.hpp"
+
+/*
+ * C++ interface tests. Parsers of all policies live in one binary and are
+ * compared with the C parser in the same mode: linked ones with
+ * jsmn_parse_soa(), which keeps parents, the others with jsmn_parse().
+ */
+
+template <typename Policy>
+static int parse_same_as_c(const char *js) {
+	jsmn::parser<Policy> p;
+	typename Policy::token_type tok[64];
+	jsmn_parser cp;
+	jsmntok_t cref[64];
+	unsigned char type[64];
+	jsmnint_t start[64], end[64], size[64], parent[64];
+	jsmn_soa soa = { type, start, end, size, parent };
+	int r, rref;
+	int i;
+
+	r = p.parse(js, tok);
+	jsmn_init(&cp);
+	cp.strict = Policy::strict;
+	if (Policy::parent_links) {
+		rref = jsmn_parse_soa(&cp, js, strlen(js), &soa, 64);
+	} else {
+		rref = jsmn_parse(&cp, js, strlen(js), cref, 64);
+		for (i = 0; i < (int) cp.toknext; i++) {
+			type[i] = (unsigned char) cref[i].type;
+			start[i] = cref[i].start;
+			end[i] = cref[i].end;
+			size[i] = cref[i].size;
+		}
+	}
+	if (r != rref || p.pos != cp.pos || p.toknext != cp.toknext ||
+			p.errpos != cp.errpos) {
+		return 0;
+	}
+	for (i = 0; i < (int) cp.toknext; i++) {
+		if (tok[i].type != type[i] || tok[i].start != start[i] ||
+				tok[i].end != end[i] || tok[i].size != size[i]) {
+			return 0;
+		}
+		if constexpr (Policy::parent_links) {
+			if (tok[i].parent != parent[i]) {
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+typedef jsmn::policy<false, false> lenient_unlinked;
+typedef jsmn::policy<true, false> strict_unlinked;
+typedef jsmn::policy<false, false, short> lenient_compact;
+
+int test_cpp_same_as_c(void) {
+	static const char *docs[] = {
+		"{}", "[{},{}]", "{\"a\": 0, \"b\": \"c\"}",
+		"{\"a\": [1, true, null, {\"b\": \"\\u00e9\"}]}",
+		"[10}", "{\"a\": 1]", "{\"a\":\"str\\uFFGFstr\"}",
+		"key1: \"value\"\nkey2 : 123", "{\"a\": 0", "[1, 2, [3, \"a\"], null]",
+		"{\"a\": {\"b\": [1, {\"c\": 2}]}, \"d\": [[], {}]}",
+	};
+	unsigned int i;
+	for (i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+		check(parse_same_as_c<jsmn::default_policy>(docs[i]));
+		check(parse_same_as_c<jsmn::strict_policy>(docs[i]));
+		check(parse_same_as_c<jsmn::compact_policy>(docs[i]));
+		check(parse_same_as_c<lenient_unlinked>(docs[i]));
+		check(parse_same_as_c<strict_unlinked>(docs[i]));
+		check(parse_same_as_c<lenient_compact>(docs[i]));
+		check(parse_same_as_c<jsmn::c_policy>(docs[i]));
+	}
+	return 0;
+}
+
+int test_cpp_policies(void) {
+	const char *js = "key1: \"value\"\nkey2 : 123";
+	jsmn::parser<lenient_unlinked> lenient;
+	jsmn::parser<jsmn::strict_policy> strict;
+	lenient_unlinked::token_type tok[8];
+	jsmn::strict_policy::token_type stok[8];
+	jsmn_error err;
+
+	check(sizeof(tok[0]) == sizeof(int) * 4);
+	check(sizeof(stok[0]) == sizeof(int) * 5);
+	check(lenient.parse(js, tok) == 4);
+	check(strict.parse(js, stok) == JSMN_ERROR_INVAL);
+	jsmn_get_error(&strict, js, &err);
+	check(err.pos == 0 && err.line == 1);
+	check(lenient.count("[1, [2, 3]]") == 4);
+
+	/* Links are kept by the linked policy only */
+	strict.reset();
+	check(strict.parse("{\"a\": [1, 2]}", stok) == 5);
+	check(stok[0].parent == -1 && stok[1].parent == 0 &&
+			stok[2].parent == 1 && stok[4].parent == 2);
+	return 0;
+}
+
+int test_cpp_keys(void) {
+	const char *names[] = { "b" };
+	const char *js = "{\"a\": [1, 2], \"b\": 3}";
+	jsmn::parser<> p;
+	jsmn_keyset set;
+	jsmn::default_policy::token_type tok[8];
+
+	/* Options of jsmn_parser apply, and reset() keeps them */
+	check(jsmn_keyset_init(&set, names, 1) == 0);
+	p.keys = &set;
+	check(p.parse(js, tok) == 3);
+	check(tok[0].size == 1 && tok[2].start == 19 && tok[2].parent == 1);
+	p.reset();
+	check(p.count(js) == 3);
+	return 0;
+}
+
+int test_cpp_compact(void) {
+	jsmn::parser<jsmn::compact_policy> p;
+	jsmn::compact_policy::token_type tok[4];
+	static char big[40000];
+
+	check(sizeof(tok[0]) == 10);
+	check(sizeof(lenient_compact::token_type) == 8);
+	check(p.parse("[1, 2]", tok) == 3);
+	check(tok[2].start == 4 && tok[2].parent == 0);
+
+	memset(big, ' ', sizeof(big) - 1);
+	big[0] = '[';
+	big[sizeof(big) - 2] = ']';
+	p.reset();
+	check(p.parse(std::string_view(big, sizeof(big) - 1), tok) ==
+			JSMN_ERROR_NOMEM);
+
+	/* int tokens take the same input */
+	jsmn::parser<jsmn::strict_policy> wide;
+	jsmn::strict_policy::token_type wtok[4];
+	check(wide.parse(std::string_view(big, sizeof(big) - 1), wtok) == 1);
+	check(wtok[0].end == (int) sizeof(big) - 1);
+	return 0;
+}
+
+int test_cpp_views(void) {
+	const char *js = "{\"user\": \"johndoe\", \"admin\": false, \"uid\": 1000,\n  "
+		"\"groups\": [\"users\", \"wheel\", \"audio\", \"video\"]}";
+	jsmn::parser<> p;
+	jsmn::default_policy::token_type tok[32];
+	int r, n;
+
+	r = p.parse(js, tok);
+	check(r == 13);
+
+	jsmn::document<jsmn::default_policy::token_type> doc(js, tok, r);
+	auto root = doc.root();
+	check(root.is_object() && root.size() == 4);
+	check(root["user"].str() == "johndoe");
+	check(root["admin"].is_primitive() && root["admin"].str() == "false");
+	check(root["uid"].str() == "1000");
+	check(!root["missing"]);
+	check(root["groups"].is_array() && root["groups"].size() == 4);
+	check(root["groups"][2].str() == "audio");
+	check(!root["groups"][4]);
+
+	n = 0;
+	for (auto key : root) {
+		check(key.is_string() && key.size() == 1);
+		n++;
+	}
+	check(n == 4);
+
+	n = 0;
+	for (auto g : root["groups"]) {
+		check(g.is_string());
+		n++;
+	}
+	check(n == 4);
+	return 0;
+}
+
+int main(void) {
+	test(test_cpp_same_as_c, "test C++ parser against the C one");
+	test(test_cpp_policies, "test policies of both modes and layouts in one binary");
+	test(test_cpp_keys, "test parser options from the C parser");
+	test(test_cpp_compact, "test 16-bit tokens");
+	test(test_cpp_views, "test value views and child iteration");
+	printf("\nPASSED: %d\nFAILED: %d\n", test_passed, test_failed);
+	return (test_failed > 0);
+}
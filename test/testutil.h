@@ -1,7 +1,8 @@
 #ifndef __TEST_UTIL_H__
 #define __TEST_UTIL_H__
 
-#include "../jsmn.c"
+#define JSMN_STATIC
+#include "../jsmn.h"
 
 static int vtokeq(const char *s, jsmntok_t *t, int numtok, va_list ap) {
 	if (numtok > 0) {